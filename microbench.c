@@ -0,0 +1,457 @@
+// Microbenchmarks for the scheduler's hot kernels, run without the validator or any IPC.
+// Every kernel is timed over a few sizes and reported in ns/op together with the heap
+// allocations it made per op.
+//
+// gcc -O2 -o microbench.out microbench.c -lpthread
+// ./microbench.out [name filter]
+
+// scheduler.c needs the GNU extensions, and they have to be on before the first header
+#define _GNU_SOURCE
+#include <stdlib.h>
+
+// every allocation made by scheduler.c while a kernel runs is counted here
+long long benchAllocations = 0;
+long long benchAllocatedBytes = 0;
+
+void *countingMalloc(size_t size)
+{
+    benchAllocations++;
+    benchAllocatedBytes += size;
+    return malloc(size);
+}
+
+void *countingRealloc(void *ptr, size_t size)
+{
+    benchAllocations++;
+    benchAllocatedBytes += size;
+    return realloc(ptr, size);
+}
+
+#define malloc(size) countingMalloc(size)
+#define realloc(ptr, size) countingRealloc(ptr, size)
+
+#define SCHEDULER_OFFLINE
+#include "scheduler.c"
+
+#define BENCH_MIN_NS 200000000LL
+#define BENCH_MAX_SHIPS 4096
+#define BENCH_MAX_DOCKS 4096
+#define BENCH_MAX_CATEGORY 25
+
+typedef struct Benchmark
+{
+    const char *name;
+    int sizes[4];
+    void (*setup)(int size);
+    void (*reset)(int size);
+    long long (*run)(int size);
+} Benchmark;
+
+unsigned int benchState = 12345;
+Ship *pristineShips;
+char *authOutput;
+int authOutputCount = 0;
+char authDecoded[MAX_AUTH_STRING_LEN];
+int cargoShipIndex;
+volatile int benchSink;
+
+// here we are drawing a number in [low, high]
+int benchRandom(int low, int high)
+{
+    benchState = benchState * 1103515245u + 12345u;
+    return low + (int)((benchState >> 8) % (unsigned int)(high - low + 1));
+}
+
+// here we are filling the ships array with waiting ships of every kind, growing it and the
+// cargo buffers the same way the scheduler does
+void fillShips(int count)
+{
+    while (shipCapacity < count)
+    {
+        growShips();
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        ships[i].id = i;
+        ships[i].direction = benchRandom(0, 1) ? 1 : -1;
+        ships[i].category = benchRandom(1, BENCH_MAX_CATEGORY);
+        ships[i].emergency = benchRandom(0, 19) == 0;
+        ships[i].waitingTime = benchRandom(1, 20);
+        ships[i].arrivalTimestep = benchRandom(1, 1000);
+        ships[i].numCargo = benchRandom(1, MAX_CARGO_COUNT);
+        ships[i].cargoWeights = reserveCargoBuffer(ships[i].cargoWeights, &ships[i].cargoCapacity, ships[i].numCargo);
+        ships[i].docked = benchRandom(0, 9) == 0;
+        ships[i].serviced = benchRandom(0, 9) == 0;
+        ships[i].remainingCargo = ships[i].numCargo;
+        ships[i].deadline = ships[i].direction == 1 && !ships[i].emergency
+                                ? ships[i].arrivalTimestep + ships[i].waitingTime
+                                : INT_MAX;
+    }
+    shipCount = count;
+}
+
+// here we are building docks of random categories, about half of them occupied
+void fillDocks(int count)
+{
+    numDocks = count;
+    for (int i = 0; i < count; i++)
+    {
+        docks[i].id = i;
+        docks[i].category = benchRandom(1, BENCH_MAX_CATEGORY);
+        docks[i].occupied = benchRandom(0, 1);
+        docks[i].reserved = false;
+        for (int j = 0; j < docks[i].category; j++)
+        {
+            docks[i].craneCapacities[j] = benchRandom(1, 30);
+        }
+    }
+    initializeFreeDocks();
+}
+
+// auth string enumeration, size is the string length and an op is one generated string
+void setupAuthRecursive(int length)
+{
+    free(authOutput);
+
+    authOutputCount = length == 1 ? 5 : 25 * powie[length - 2];
+    authOutput = (char *)malloc((size_t)authOutputCount * (length + 1));
+}
+
+long long runAuthRecursive(int length)
+{
+    char FirstAndLast[] = "56789";
+    char middleChars[] = "56789.";
+    generateAuthStringsOfLength(length, FirstAndLast, middleChars, authOutput);
+    return authOutputCount;
+}
+
+// the table-free path used under a tight --mem-budget, an op is one decoded string
+long long runAuthDecode(int length)
+{
+    int count = length == 1 ? 5 : 25 * powie[length - 2];
+    for (int i = 0; i < count; i++)
+    {
+        decodeAuthString(length, i, authDecoded);
+    }
+    benchSink = authDecoded[0];
+    return count;
+}
+
+// dock selection, size is the number of docks and an op is one GetBestDock call
+void setupBestDock(int count)
+{
+    fillDocks(count);
+    fillShips(BENCH_MAX_CATEGORY);
+}
+
+long long runBestDock(int count)
+{
+    (void)count;
+    int found = 0;
+    for (int i = 0; i < BENCH_MAX_CATEGORY; i++)
+    {
+        found += GetBestDock(i) != -1;
+    }
+    benchSink = found;
+    return BENCH_MAX_CATEGORY;
+}
+
+// crane fitting, size is the number of cargo items on the docked ship and an op is one
+// item moved. the ship sits at the end of a full ships array like a late arrival would
+void setupMoveCargo(int numCargo)
+{
+    fillDocks(1);
+    docks[0].category = BENCH_MAX_CATEGORY;
+    for (int j = 0; j < BENCH_MAX_CATEGORY; j++)
+    {
+        docks[0].craneCapacities[j] = benchRandom(1, 30);
+    }
+    docks[0].craneCapacities[0] = 30;
+
+    fillShips(1000);
+    cargoShipIndex = shipCount - 1;
+    ships[cargoShipIndex].numCargo = numCargo;
+    ships[cargoShipIndex].cargoWeights = reserveCargoBuffer(ships[cargoShipIndex].cargoWeights,
+                                                            &ships[cargoShipIndex].cargoCapacity, numCargo);
+    for (int i = 0; i < numCargo; i++)
+    {
+        ships[cargoShipIndex].cargoWeights[i] = benchRandom(1, 30);
+    }
+
+    docks[0].remainingCargoWeights = reserveCargoBuffer(docks[0].remainingCargoWeights, &docks[0].cargoCapacity, numCargo);
+}
+
+void resetMoveCargo(int numCargo)
+{
+    docks[0].occupied = true;
+    docks[0].shipId = ships[cargoShipIndex].id;
+    docks[0].direction = ships[cargoShipIndex].direction;
+    docks[0].dockingTimestep = 0;
+    docks[0].remainingCargo = numCargo;
+    memcpy(docks[0].remainingCargoWeights, ships[cargoShipIndex].cargoWeights, numCargo * sizeof(int));
+    ships[cargoShipIndex].remainingCargo = numCargo;
+}
+
+long long runMoveCargo(int numCargo)
+{
+    for (currentTimestep = 1; docks[0].remainingCargo > 0; currentTimestep++)
+    {
+        craneEpoch++;
+        while (moveCargo(0))
+        {
+        }
+    }
+    return numCargo;
+}
+
+// priority sort, size is the number of ships and an op is one full qsort
+void setupSort(int count)
+{
+    fillShips(count);
+    memcpy(pristineShips, ships, count * sizeof(Ship));
+}
+
+void resetSort(int count)
+{
+    memcpy(ships, pristineShips, count * sizeof(Ship));
+}
+
+long long runSort(int count)
+{
+    qsort(ships, count, sizeof(Ship), compareShipPriority);
+    return 1;
+}
+
+// here we are handing back the ships array and its cargo buffers and starting it over at its
+// initial capacity, like a scheduler that has just started
+void resetShips()
+{
+    for (int i = 0; i < shipCapacity; i++)
+    {
+        schedFree(MEM_CARGO, ships[i].cargoWeights);
+    }
+    schedFree(MEM_SHIPS, ships);
+    initializeShips();
+    shipCount = 0;
+}
+
+// ingestion, size is the number of requests and an op is one addShip into an array that
+// starts at its initial capacity, so the doubling and the new cargo buffers are counted
+void setupAddShip(int count)
+{
+    (void)count;
+    memset(shmPtr, 0, sizeof(MainSharedMemory));
+}
+
+void resetAddShip(int count)
+{
+    (void)count;
+    resetShips();
+}
+
+long long runAddShip(int count)
+{
+    ShipRequest req;
+    memset(&req, 0, sizeof(req));
+    req.numCargo = 20;
+    for (int i = 0; i < count; i++)
+    {
+        req.shipId = i;
+        req.direction = (i & 1) ? 1 : -1;
+        req.timestep = i;
+        req.category = 1 + i % BENCH_MAX_CATEGORY;
+        req.waitingTime = 5;
+        addShip(req);
+    }
+    return count;
+}
+
+// dock planning, size is the number of ships and an op is one planDocking pass over
+// 256 docks with a 10 timestep horizon
+void setupPlan(int count)
+{
+    fillDocks(256);
+    for (int i = 0; i < numDocks; i++)
+    {
+        docks[i].numCargo = benchRandom(1, 50);
+        docks[i].remainingCargo = docks[i].numCargo;
+        docks[i].dockingTimestep = 490;
+        docks[i].remainingCargoWeights = reserveCargoBuffer(docks[i].remainingCargoWeights, &docks[i].cargoCapacity,
+                                                            docks[i].numCargo);
+        for (int j = 0; j < docks[i].numCargo; j++)
+        {
+            docks[i].remainingCargoWeights[j] = benchRandom(0, 30);
+        }
+    }
+
+    fillShips(count);
+    for (int i = 0; i < count; i++)
+    {
+        for (int j = 0; j < ships[i].numCargo; j++)
+        {
+            ships[i].cargoWeights[j] = benchRandom(1, 30);
+        }
+    }
+
+    schedFree(MEM_DOCKS, planAvailableAt);
+    schedFree(MEM_SHIPS, plannedDock);
+    schedFree(MEM_SHIPS, planCandidates);
+    initializePlanner();
+    planHorizon = 10;
+    currentTimestep = 500;
+}
+
+long long runPlan(int count)
+{
+    (void)count;
+    planDocking();
+    return 1;
+}
+
+// emergency intake, size is the number of ships the scheduler has already taken in, all
+// since serviced. emergencies arrive through addShip one per timestep until every dock holds
+// one. the first kernel times addShip and the lane dispatch alone; the second times the whole
+// processTimestep, which also walks the ships array once for regular docking. the timestep
+// never advances, so the docked emergencies move their cargo but never undock
+void setupEmergency(int count)
+{
+    fillDocks(64);
+    fillShips(count);
+    for (int i = 0; i < count; i++)
+    {
+        ships[i].docked = false;
+        ships[i].serviced = true;
+    }
+    planHorizon = 0;
+    currentTimestep = 1000;
+}
+
+void resetEmergency(int count)
+{
+    for (int i = 0; i < numDocks; i++)
+    {
+        docks[i].occupied = false;
+        updateFreeDock(i);
+    }
+    shipCount = count;
+}
+
+// here we are making the emergency request for one timestep
+ShipRequest *emergencyRequest(int shipId)
+{
+    ShipRequest *req = &shmPtr->newShipRequests[0];
+    memset(req, 0, sizeof(*req));
+    req->shipId = shipId;
+    req->direction = 1;
+    req->emergency = 1;
+    req->category = 1;
+    req->timestep = currentTimestep;
+    req->numCargo = 20;
+    for (int j = 0; j < req->numCargo; j++)
+    {
+        req->cargo[j] = 1 + j;
+    }
+    return req;
+}
+
+long long runEmergencyIntake(int count)
+{
+    for (int i = 0; i < numDocks; i++)
+    {
+        addShip(*emergencyRequest(count + i));
+        dispatchEmergencyLane();
+    }
+    return numDocks;
+}
+
+long long runEmergencyTimestep(int count)
+{
+    for (int i = 0; i < numDocks; i++)
+    {
+        emergencyRequest(count + i);
+        processTimestep(1);
+    }
+    return numDocks;
+}
+
+Benchmark benchmarks[] = {
+    {"auth/generateAuthStringRecursive", {4, 6, 8, 0}, setupAuthRecursive, NULL, runAuthRecursive},
+    {"auth/decodeAuthString", {4, 6, 8, 0}, NULL, NULL, runAuthDecode},
+    {"dock/GetBestDock", {16, 256, 1024, 4096}, setupBestDock, NULL, runBestDock},
+    {"cargo/moveCargo", {10, 50, 200, 0}, setupMoveCargo, resetMoveCargo, runMoveCargo},
+    {"sort/compareShipPriority", {100, 1000, 4096, 0}, setupSort, resetSort, runSort},
+    {"ingest/addShip", {100, 1000, 4096, 16384}, setupAddShip, resetAddShip, runAddShip},
+    {"plan/planDocking", {100, 1000, 4096, 0}, setupPlan, NULL, runPlan},
+    {"emergency/addShip", {100, 1000, 10000, 100000}, setupEmergency, resetEmergency, runEmergencyIntake},
+    {"emergency/processTimestep", {100, 1000, 10000, 100000}, setupEmergency, resetEmergency, runEmergencyTimestep},
+};
+
+// here we are repeating a kernel until it has run long enough to give a stable number
+void runBenchmark(Benchmark *bench, int size)
+{
+    if (bench->setup != NULL)
+        bench->setup(size);
+
+    long long ops = 0, ns = 0, allocations = 0, bytes = 0;
+    while (ns < BENCH_MIN_NS)
+    {
+        if (bench->reset != NULL)
+            bench->reset(size);
+
+        long long allocationsBefore = benchAllocations;
+        long long bytesBefore = benchAllocatedBytes;
+        long long start = monotonicNs();
+
+        ops += bench->run(size);
+
+        ns += monotonicNs() - start;
+        allocations += benchAllocations - allocationsBefore;
+        bytes += benchAllocatedBytes - bytesBefore;
+    }
+
+    printf("%-34s %6d %12lld %12.1f %12.3f %12.1f\n", bench->name, size, ops,
+           (double)ns / ops, (double)allocations / ops, (double)bytes / ops);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *filter = argc > 1 ? argv[1] : NULL;
+
+    static MainSharedMemory benchShm;
+    shmPtr = &benchShm;
+
+    // the kernels grow and free these through the tagged allocators, so they have to come
+    // from them too; cranes are sized for the largest category any kernel gives a dock
+    docks = (Dock *)schedMalloc(MEM_DOCKS, BENCH_MAX_DOCKS * sizeof(Dock));
+    if (docks == NULL)
+    {
+        perror("Failed to allocate memory for docks");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < BENCH_MAX_DOCKS; i++)
+    {
+        docks[i].category = BENCH_MAX_CATEGORY;
+        allocateCranes(&docks[i]);
+        docks[i].remainingCargoWeights = NULL;
+        docks[i].cargoCapacity = 0;
+    }
+
+    initializeShips();
+    pristineShips = (Ship *)malloc(BENCH_MAX_SHIPS * sizeof(Ship));
+
+    printf("%-34s %6s %12s %12s %12s %12s\n", "kernel", "size", "ops", "ns/op", "allocs/op", "bytes/op");
+
+    for (size_t b = 0; b < sizeof(benchmarks) / sizeof(benchmarks[0]); b++)
+    {
+        if (filter != NULL && strstr(benchmarks[b].name, filter) == NULL)
+            continue;
+
+        for (int s = 0; s < 4 && benchmarks[b].sizes[s] > 0; s++)
+        {
+            runBenchmark(&benchmarks[b], benchmarks[b].sizes[s]);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,334 @@
+// Runs every scheduling policy over the same synthetic workload without the validator.
+// The main queue is stubbed out, but the solver queues are real private message queues
+// answered by emulator threads, so undocking goes through the normal solver threads.
+//
+// gcc -o policy_harness.out policy_harness.c -lpthread
+// ./policy_harness.out [seed] [numDocks] [numShips] [numSolvers] [planHorizon] [threaded|evloop]
+// With a plan horizon every policy is also run with the dock planner on. The last argument
+// picks the solver engine, whose cost report is printed at the end with the memory report.
+
+#define SCHEDULER_OFFLINE
+#define SCHEDULER_POLICY_RUNTIME
+#include "scheduler.c"
+
+#define HARNESS_MAX_CATEGORY 8
+#define HARNESS_MAX_WEIGHT 20
+#define HARNESS_MAX_EXTRA_STEPS 2000
+
+typedef struct HarnessResult
+{
+    int timesteps;
+    int serviced;
+    int missedDeadlines;
+    long long guesses;
+    long long messages;
+    double wallMs;
+} HarnessResult;
+
+unsigned int harnessSeed;
+ShipRequest *workload;
+int workloadSize;
+int lastArrivalTimestep;
+long long harnessGuesses = 0;
+MainSharedMemory harnessShm;
+
+// here we are drawing a number in [low, high] from the workload generator
+int harnessRandom(unsigned int *state, int low, int high)
+{
+    *state = *state * 1103515245u + 12345u;
+    return low + (int)((*state >> 8) % (unsigned int)(high - low + 1));
+}
+
+// here we are generating docks and the ship requests, ordered by arrival timestep
+void generateWorkload(int dockCount, int shipTotal)
+{
+    unsigned int state = harnessSeed;
+
+    numDocks = dockCount;
+    docks = (Dock *)schedMalloc(MEM_DOCKS, numDocks * sizeof(Dock));
+    if (docks == NULL)
+    {
+        perror("Failed to allocate memory for docks");
+        exit(EXIT_FAILURE);
+    }
+
+    int maxDockCategory = 1;
+    for (int i = 0; i < numDocks; i++)
+    {
+        docks[i].id = i;
+        docks[i].occupied = false;
+        docks[i].reserved = false;
+        docks[i].category = harnessRandom(&state, 1, HARNESS_MAX_CATEGORY);
+        docks[i].remainingCargoWeights = NULL;
+        docks[i].cargoCapacity = 0;
+        allocateCranes(&docks[i]);
+
+        // every dock gets one crane that can lift anything, otherwise a ship could stay docked forever
+        docks[i].craneCapacities[0] = HARNESS_MAX_WEIGHT;
+        for (int j = 1; j < docks[i].category; j++)
+        {
+            docks[i].craneCapacities[j] = harnessRandom(&state, 1, HARNESS_MAX_WEIGHT);
+        }
+
+        if (docks[i].category > maxDockCategory)
+            maxDockCategory = docks[i].category;
+    }
+
+    initializeFreeDocks();
+
+    workloadSize = shipTotal;
+    workload = (ShipRequest *)malloc(workloadSize * sizeof(ShipRequest));
+    if (workload == NULL)
+    {
+        perror("Failed to allocate memory for workload");
+        exit(EXIT_FAILURE);
+    }
+
+    int arrivalWindow = shipTotal / 3 > 0 ? shipTotal / 3 : 1;
+    int nextId[2] = {0, 0};
+    lastArrivalTimestep = 0;
+
+    for (int i = 0; i < workloadSize; i++)
+    {
+        ShipRequest *req = &workload[i];
+        req->timestep = harnessRandom(&state, 1, arrivalWindow);
+        req->direction = harnessRandom(&state, 0, 1) ? 1 : -1;
+        req->emergency = (req->direction == 1 && harnessRandom(&state, 0, 19) == 0) ? 1 : 0;
+        req->waitingTime = harnessRandom(&state, 1, 10);
+        req->category = harnessRandom(&state, 1, maxDockCategory);
+        req->shipId = nextId[req->direction == 1]++;
+
+        // keep cargo per crane small so auth strings stay short enough for the emulated solvers
+        req->numCargo = harnessRandom(&state, 1, req->category + 1);
+        for (int j = 0; j < req->numCargo; j++)
+        {
+            req->cargo[j] = harnessRandom(&state, 1, HARNESS_MAX_WEIGHT / 2);
+        }
+
+        if (req->timestep > lastArrivalTimestep)
+            lastArrivalTimestep = req->timestep;
+    }
+
+    for (int i = 1; i < workloadSize; i++)
+    {
+        ShipRequest req = workload[i];
+        int j = i - 1;
+        while (j >= 0 && workload[j].timestep > req.timestep)
+        {
+            workload[j + 1] = workload[j];
+            j--;
+        }
+        workload[j + 1] = req;
+    }
+}
+
+// here we are answering solver requests like the validator does, with a secret that depends
+// only on the dock and its docking timestep so all emulators agree on it. a solver thread can
+// notify and then give up without guessing, so the secret is only picked at the first guess,
+// while the main thread is still waiting in undockShip and the dock can't change under us
+void *emulateSolver(void *arg)
+{
+    int queueId = *(int *)arg;
+    int dockId = -1;
+    char secret[MAX_AUTH_STRING_LEN] = "";
+    SolverRequest req;
+
+    while (msgrcv(queueId, &req, sizeof(SolverRequest) - sizeof(long), -2, 0) != -1)
+    {
+        if (req.mtype == 1)
+        {
+            dockId = req.dockId;
+            secret[0] = '\0';
+            continue;
+        }
+
+        if (secret[0] == '\0' && dockId != -1)
+        {
+            Dock *dock = &docks[dockId];
+            int length = dock->lastCargoMovedTimestep - dock->dockingTimestep;
+            unsigned int hash = harnessSeed ^ (unsigned int)(dock->id * 7919 + dock->dockingTimestep * 104729);
+            int index = harnessRandom(&hash, 0, authStringCounts[length] - 1);
+            copyAuthString(length, index, secret);
+        }
+
+        __atomic_add_fetch(&harnessGuesses, 1, __ATOMIC_RELAXED);
+
+        SolverResponse resp;
+        resp.mtype = 3;
+        resp.guessIsCorrect = strcmp(req.authStringGuess, secret) == 0;
+        if (msgsnd(queueId, &resp, sizeof(SolverResponse) - sizeof(long), 0) == -1)
+        {
+            perror("msgsnd failed for emulated solver response");
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+// here we are clearing docks and ships so the next policy starts from the same port.
+// cargo buffers are kept, like the scheduler keeps them between dockings
+void resetPortState()
+{
+    for (int i = 0; i < numDocks; i++)
+    {
+        docks[i].occupied = false;
+        docks[i].reserved = false;
+        updateFreeDock(i);
+    }
+
+    for (int i = 0; i < shipCount; i++)
+    {
+        ships[i].serviced = true;
+        ships[i].docked = false;
+    }
+    shipCount = 0;
+    laneCount = 0;
+    laneMinCategory = INT_MAX;
+    laneWakeup = false;
+}
+
+// here we are checking whether every ship has either left the port or missed its deadline
+bool portSettled()
+{
+    if (laneCount > 0)
+        return false;
+
+    for (int i = 0; i < numDocks; i++)
+    {
+        if (docks[i].occupied)
+            return false;
+    }
+
+    for (int i = 0; i < shipCount; i++)
+    {
+        if (!ships[i].serviced && shipWithinDeadline(i))
+            return false;
+    }
+
+    return true;
+}
+
+// here we are running the whole workload under one policy
+HarnessResult runPolicy(SchedulingPolicy *policy, int horizon)
+{
+    HarnessResult result;
+    activePolicy = policy;
+    planHorizon = horizon;
+    resetPortState();
+
+    long long guessesBefore = harnessGuesses;
+    long long messagesBefore = offlineMessagesSent;
+    long long start = monotonicNs();
+
+    int next = 0;
+    int timestep;
+    for (timestep = 1; timestep <= lastArrivalTimestep + HARNESS_MAX_EXTRA_STEPS; timestep++)
+    {
+        currentTimestep = timestep;
+
+        int numNewRequests = 0;
+        while (next < workloadSize && workload[next].timestep == timestep && numNewRequests < MAX_NEW_REQUESTS)
+        {
+            shmPtr->newShipRequests[numNewRequests++] = workload[next++];
+        }
+
+        processTimestep(numNewRequests);
+
+        if (next == workloadSize && portSettled())
+            break;
+    }
+
+    result.wallMs = (monotonicNs() - start) / 1e6;
+    result.timesteps = timestep;
+    result.guesses = harnessGuesses - guessesBefore;
+    result.messages = offlineMessagesSent - messagesBefore;
+    result.serviced = 0;
+    result.missedDeadlines = 0;
+
+    for (int i = 0; i < shipCount; i++)
+    {
+        if (ships[i].serviced)
+            result.serviced++;
+        else if (!shipWithinDeadline(i))
+            result.missedDeadlines++;
+    }
+
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    harnessSeed = argc > 1 ? (unsigned int)atoi(argv[1]) : 1;
+    int dockCount = argc > 2 ? atoi(argv[2]) : 20;
+    int shipTotal = argc > 3 ? atoi(argv[3]) : 300;
+    numSolvers = argc > 4 ? atoi(argv[4]) : 4;
+    int horizon = argc > 5 ? atoi(argv[5]) : 0;
+    if (argc > 6 && strcmp(argv[6], "evloop") == 0)
+        solverEngine = SOLVER_ENGINE_EVLOOP;
+
+    if (dockCount < 1 || dockCount > MAX_DOCKS || shipTotal < 1 || numSolvers < 1)
+    {
+        fprintf(stderr, "Usage: %s [seed] [numDocks <= %d] [numShips] [numSolvers] [planHorizon] [threaded|evloop]\n",
+                argv[0], MAX_DOCKS);
+        exit(EXIT_FAILURE);
+    }
+
+    shmPtr = &harnessShm;
+    generateWorkload(dockCount, shipTotal);
+    initializeShips();
+    initializePlanner();
+    planAuthTables();
+    precomputeAuthStrings();
+
+    solverMsgQueueIds = (int *)schedMalloc(MEM_SOLVER, numSolvers * sizeof(int));
+    pthread_t *emulators = (pthread_t *)malloc(numSolvers * sizeof(pthread_t));
+    if (solverMsgQueueIds == NULL || emulators == NULL)
+    {
+        perror("Failed to allocate memory for solver queues");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < numSolvers; i++)
+    {
+        solverMsgQueueIds[i] = msgget(IPC_PRIVATE, IPC_CREAT | 0600);
+        if (solverMsgQueueIds[i] == -1)
+        {
+            perror("msgget failed for solver queue");
+            exit(EXIT_FAILURE);
+        }
+        pthread_create(&emulators[i], NULL, emulateSolver, &solverMsgQueueIds[i]);
+    }
+
+    printf("workload: seed %u, %d docks, %d ships arriving over %d timesteps, %d solvers\n",
+           harnessSeed, numDocks, workloadSize, lastArrivalTimestep, numSolvers);
+    printf("%-14s %10s %10s %10s %14s %12s %10s %10s\n",
+           "policy", "timesteps", "serviced", "missed", "ships/100step", "guesses", "messages", "wall ms");
+
+    for (int p = 0; p < numSchedulingPolicies; p++)
+    {
+        for (int planned = 0; planned <= (horizon > 0); planned++)
+        {
+            char name[32];
+            snprintf(name, sizeof(name), "%s%s", schedulingPolicies[p].name, planned ? "+plan" : "");
+
+            HarnessResult result = runPolicy(&schedulingPolicies[p], planned ? horizon : 0);
+            printf("%-14s %10d %10d %10d %14.2f %12lld %10lld %10.1f\n",
+                   name, result.timesteps, result.serviced, result.missedDeadlines,
+                   100.0 * result.serviced / result.timesteps, result.guesses, result.messages, result.wallMs);
+        }
+    }
+
+    fflush(stdout);
+    printSolverEngineReport();
+    printMemoryReport("Memory at exit", true);
+
+    for (int i = 0; i < numSolvers; i++)
+    {
+        msgctl(solverMsgQueueIds[i], IPC_RMID, NULL);
+        pthread_join(emulators[i], NULL);
+    }
+    free(emulators);
+
+    return 0;
+}
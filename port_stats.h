@@ -0,0 +1,82 @@
+#ifndef PORT_STATS_H
+#define PORT_STATS_H
+
+// Layout of the live stats segment the scheduler publishes when started with --stats-key.
+// The segment is a PortStats header followed by numSolvers SolverQueueStats and numDocks
+// DockStats. The scheduler only ever does plain stores into it, and readers take consistent
+// copies with the sequence counter: it is odd while an update is in progress and readers
+// retry until they see the same even value before and after copying.
+// Solver guess counters are bumped atomically by the solver threads outside the sequence
+// and only ever grow.
+
+#define PORT_STATS_MAGIC 0x50535441
+#define PORT_STATS_VERSION 1
+
+enum
+{
+    PHASE_INGEST,
+    PHASE_DOCK,
+    PHASE_CARGO,
+    PHASE_UNDOCK,
+    PHASE_CHECKPOINT,
+    NUM_PHASES
+};
+
+typedef struct SolverQueueStats
+{
+    int queueId;
+    int busy;
+    unsigned long long guesses;
+} SolverQueueStats;
+
+typedef struct DockStats
+{
+    int category;
+    int occupied;
+    int shipId;
+    int direction;
+    int remainingCargo;
+} DockStats;
+
+typedef struct PortStats
+{
+    unsigned int magic;
+    int version;
+    unsigned int sequence;
+    int schedulerPid;
+    int numSolvers;
+    int numDocks;
+    int mainQueueId;
+
+    int timestep;
+    int shipsWaiting;
+    int shipsDocked;
+    int shipsServiced;
+    int deadlineMisses;
+    int docksOccupied;
+
+    int undockInProgress;
+    int undockDockId;
+    int undockStringLength;
+    unsigned long long undocksCompleted;
+
+    long long lastPhaseNs[NUM_PHASES];
+    long long totalPhaseNs[NUM_PHASES];
+} PortStats;
+
+static inline size_t portStatsSize(int numSolvers, int numDocks)
+{
+    return sizeof(PortStats) + numSolvers * sizeof(SolverQueueStats) + numDocks * sizeof(DockStats);
+}
+
+static inline SolverQueueStats *portStatsSolvers(PortStats *stats)
+{
+    return (SolverQueueStats *)(stats + 1);
+}
+
+static inline DockStats *portStatsDocks(PortStats *stats)
+{
+    return (DockStats *)(portStatsSolvers(stats) + stats->numSolvers);
+}
+
+#endif
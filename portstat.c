@@ -0,0 +1,201 @@
+// Live view of a running scheduler, read from the stats segment it publishes with --stats-key.
+//
+// gcc -o portstat.out portstat.c
+// ./portstat.out <stats_key> [interval_ms] [--once]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/ipc.h>
+#include <sys/msg.h>
+#include <sys/shm.h>
+#include "port_stats.h"
+
+const char *phaseNames[NUM_PHASES] = {"ingest", "dock", "cargo", "undock", "checkpoint"};
+
+#define SNAPSHOT_RETRIES 1000
+#define SNAPSHOT_MAX_BACKOFF_NS 1000000
+
+// here we are taking a consistent copy of the segment, retrying while the scheduler writes.
+// retries back off up to a millisecond and give up if the scheduler dies mid-update (the
+// sequence then stays odd forever) or it keeps changing for SNAPSHOT_RETRIES attempts
+bool readSnapshot(PortStats *stats, PortStats *copy, size_t size, pid_t schedulerPid)
+{
+    long backoffNs = 1000;
+    for (int attempt = 0; attempt < SNAPSHOT_RETRIES; attempt++)
+    {
+        unsigned int before = __atomic_load_n(&stats->sequence, __ATOMIC_ACQUIRE);
+        if (!(before & 1))
+        {
+            memcpy(copy, stats, size);
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+            if (__atomic_load_n(&stats->sequence, __ATOMIC_RELAXED) == before)
+                return true;
+        }
+
+        if (kill(schedulerPid, 0) == -1 && errno == ESRCH)
+            return false;
+
+        struct timespec pause = {0, backoffNs};
+        nanosleep(&pause, NULL);
+        if (backoffNs < SNAPSHOT_MAX_BACKOFF_NS)
+            backoffNs *= 2;
+    }
+    return false;
+}
+
+// here we are asking the kernel how many messages are sitting in a queue
+long queueDepth(int queueId)
+{
+    struct msqid_ds info;
+    if (msgctl(queueId, IPC_STAT, &info) == -1)
+        return -1;
+    return (long)info.msg_qnum;
+}
+
+void printSnapshot(PortStats *now, PortStats *previous, double elapsedSec)
+{
+    printf("scheduler pid %d  timestep %d  main queue depth %ld\n",
+           now->schedulerPid, now->timestep, queueDepth(now->mainQueueId));
+    printf("ships: %d waiting, %d docked, %d serviced, %d past deadline\n",
+           now->shipsWaiting, now->shipsDocked, now->shipsServiced, now->deadlineMisses);
+
+    if (now->undockInProgress)
+        printf("undock: dock %d, auth string length %d, %llu completed\n",
+               now->undockDockId, now->undockStringLength, now->undocksCompleted);
+    else
+        printf("undock: idle, %llu completed\n", now->undocksCompleted);
+
+    printf("\n%-8s %10s %6s %14s %12s\n", "solver", "queue", "depth", "guesses", "guesses/s");
+    SolverQueueStats *solvers = portStatsSolvers(now);
+    SolverQueueStats *previousSolvers = portStatsSolvers(previous);
+    for (int i = 0; i < now->numSolvers; i++)
+    {
+        double rate = elapsedSec > 0 ? (solvers[i].guesses - previousSolvers[i].guesses) / elapsedSec : 0;
+        printf("%-8d %10d %6ld %14llu %12.0f%s\n", i, solvers[i].queueId, queueDepth(solvers[i].queueId),
+               solvers[i].guesses, rate, solvers[i].busy ? "  busy" : "");
+    }
+
+    printf("\ndocks: %d of %d occupied\n", now->docksOccupied, now->numDocks);
+    DockStats *docks = portStatsDocks(now);
+    for (int i = 0; i < now->numDocks; i++)
+    {
+        if (docks[i].occupied)
+            printf("  dock %3d  cat %2d  ship %4d %-8s  %3d cargo left\n", i, docks[i].category,
+                   docks[i].shipId, docks[i].direction == 1 ? "incoming" : "outgoing", docks[i].remainingCargo);
+        else
+            printf("  dock %3d  cat %2d  free\n", i, docks[i].category);
+    }
+
+    printf("\n%-12s %12s %14s\n", "phase", "last us", "avg us/step");
+    for (int phase = 0; phase < NUM_PHASES; phase++)
+    {
+        double average = now->timestep > 0 ? now->totalPhaseNs[phase] / 1e3 / now->timestep : 0;
+        printf("%-12s %12.1f %14.1f\n", phaseNames[phase], now->lastPhaseNs[phase] / 1e3, average);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <stats_key> [interval_ms] [--once]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    int key = atoi(argv[1]);
+    int intervalMs = 1000;
+    bool once = false;
+    for (int i = 2; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--once") == 0)
+            once = true;
+        else
+            intervalMs = atoi(argv[i]);
+    }
+
+    int shmId = shmget(key, 0, 0);
+    if (shmId == -1)
+    {
+        perror("shmget failed, is the scheduler running with --stats-key");
+        exit(EXIT_FAILURE);
+    }
+
+    PortStats *stats = (PortStats *)shmat(shmId, NULL, SHM_RDONLY);
+    if (stats == (PortStats *)-1)
+    {
+        perror("shmat failed");
+        exit(EXIT_FAILURE);
+    }
+
+    if (__atomic_load_n(&stats->magic, __ATOMIC_ACQUIRE) != PORT_STATS_MAGIC || stats->version != PORT_STATS_VERSION)
+    {
+        fprintf(stderr, "Segment %d is not a version %d port stats segment\n", key, PORT_STATS_VERSION);
+        exit(EXIT_FAILURE);
+    }
+
+    size_t size = portStatsSize(stats->numSolvers, stats->numDocks);
+    PortStats *now = (PortStats *)malloc(size);
+    PortStats *previous = (PortStats *)malloc(size);
+    if (now == NULL || previous == NULL)
+    {
+        perror("Failed to allocate memory for snapshots");
+        exit(EXIT_FAILURE);
+    }
+
+    pid_t schedulerPid = stats->schedulerPid;
+    if (!readSnapshot(stats, previous, size, schedulerPid))
+    {
+        fprintf(stderr, "Could not get a consistent snapshot, the scheduler exited or is stuck mid-update\n");
+        exit(EXIT_FAILURE);
+    }
+    struct timespec last;
+    clock_gettime(CLOCK_MONOTONIC, &last);
+
+    // --once still takes its two samples an interval apart, so the rates it prints are real
+    while (true)
+    {
+        usleep(intervalMs * 1000);
+
+        struct timespec current;
+        clock_gettime(CLOCK_MONOTONIC, &current);
+        double elapsedSec = (current.tv_sec - last.tv_sec) + (current.tv_nsec - last.tv_nsec) / 1e9;
+        last = current;
+
+        if (!readSnapshot(stats, now, size, schedulerPid))
+        {
+            printf("\nscheduler exited or is stuck mid-update\n");
+            break;
+        }
+
+        if (!once)
+            printf("\033[H\033[2J");
+        printSnapshot(now, previous, elapsedSec);
+        fflush(stdout);
+
+        if (once)
+            break;
+
+        if (kill(schedulerPid, 0) == -1)
+        {
+            printf("\nscheduler has exited\n");
+            break;
+        }
+
+        PortStats *swap = previous;
+        previous = now;
+        now = swap;
+    }
+
+    shmdt(stats);
+    free(now);
+    free(previous);
+    return 0;
+}
@@ -1,3 +1,7 @@
+// for cpu sets, thread affinity and sched_getcpu
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,14 +15,36 @@
 #include <limits.h>
 #include <time.h>
 #include <pthread.h>
-
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sched.h>
+#include <dirent.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#include "port_stats.h"
+
+// the validator's shared memory has one auth string slot per dock, so this is a protocol
+// limit; everything the scheduler keeps per dock, crane and solver is sized at startup
 #define MAX_DOCKS 30
 #define MAX_CARGO_COUNT 200
 #define MAX_AUTH_STRING_LEN 100
 #define MAX_NEW_REQUESTS 100
-#define MAX_SHIPS 1100
-#define MAX_SOLVERS 8
-#define MAX_CRANES 25
+#define INITIAL_SHIP_CAPACITY 64
+#define CHECKPOINT_MAGIC 0x504d5343
+#define CHECKPOINT_VERSION 1
+
+// scheduling policies; the one used by scheduler.out is picked at compile time with
+// -DSCHEDULER_POLICY=POLICY_FIFO etc. so the hot loop makes direct calls only.
+// tools that compare policies build with -DSCHEDULER_POLICY_RUNTIME instead
+#define POLICY_GREEDY 0
+#define POLICY_FIFO 1
+#define POLICY_FASTDOCK 2
+
+#ifndef SCHEDULER_POLICY
+#define SCHEDULER_POLICY POLICY_GREEDY
+#endif
 
 typedef struct ShipRequest
 {
@@ -72,13 +98,17 @@ typedef struct Dock
     int id;
     int category;
     int *craneCapacities;
+    int *craneUsedEpoch;
     bool occupied;
+    bool reserved;
     int shipId;
     int direction;
     int dockingTimestep;
     int lastCargoMovedTimestep;
     int remainingCargo;
+    int numCargo;
     int *remainingCargoWeights;
+    int cargoCapacity;
 } Dock;
 
 typedef struct Ship
@@ -91,6 +121,7 @@ typedef struct Ship
     int arrivalTimestep;
     int numCargo;
     int *cargoWeights;
+    int cargoCapacity;
     bool docked;
     int dockId;
     bool serviced;
@@ -106,22 +137,337 @@ typedef struct
     char *correctAuthString;
     pthread_mutex_t *mutex;
     pthread_cond_t *cond;
+    long long migrations;
+    struct rusage usage;
 } SolverThreadData;
 
+// checkpoint file layout: header, then every dock, then every ship.
+// cargo weights follow each dock/ship record, numCargo ints each
+typedef struct CheckpointHeader
+{
+    unsigned int magic;
+    int version;
+    int timestep;
+    int numDocks;
+    int shipCount;
+} CheckpointHeader;
+
+typedef struct DockSnapshot
+{
+    int category;
+    int occupied;
+    int shipId;
+    int direction;
+    int dockingTimestep;
+    int lastCargoMovedTimestep;
+    int remainingCargo;
+    int numCargo;
+} DockSnapshot;
+
+typedef struct ShipSnapshot
+{
+    int id;
+    int direction;
+    int category;
+    int emergency;
+    int waitingTime;
+    int arrivalTimestep;
+    int numCargo;
+    int docked;
+    int dockId;
+    int serviced;
+    int remainingCargo;
+    int deadline;
+} ShipSnapshot;
+
+// the step journal is a tiny mmap'd file updated with plain stores while a timestep runs,
+// so after a crash we know which step was in progress, how many of its docking and cargo
+// messages the validator has already received, which docks it has already seen undocked
+// (one bit per dock, MAX_DOCKS fits), and whether the step was checkpointed and handed
+// back to the validator with its end-of-step message
+typedef struct StepJournal
+{
+    unsigned int magic;
+    int timestep;
+    int numShipRequests;
+    int messagesSent;
+    unsigned long long undockedDocks;
+    int stepComplete;
+    int endOfStepSent;
+} StepJournal;
+
+typedef struct SchedulingPolicy
+{
+    const char *name;
+    int (*compareShips)(const void *a, const void *b);
+    int (*selectDock)(int shipIndex);
+    bool (*admitShip)(int shipIndex);
+} SchedulingPolicy;
+
 // Global variables
 int currentTimestep = 0;
 int mainMsgQueueId, shmId;
-int solverMsgQueueIds[MAX_SOLVERS];
+int *solverMsgQueueIds;
 int numSolvers, numDocks;
 MainSharedMemory *shmPtr;
 Dock *docks;
 Ship *ships;
 int shipCount = 0;
-int shipCapacity = 100;
-bool craneUsedTimestep[MAX_DOCKS][MAX_CRANES];
-char ***precomputedStrings;
-int *authStringCounts;
+int shipCapacity = 0;
+// a crane is busy for this timestep when its stamp equals craneEpoch, so moving to the
+// next timestep is one increment instead of clearing every crane
+int craneEpoch = 0;
+// auth strings of a length are either one flat table with a stride of length + 1, or NULL
+// when the memory budget has no room for it and the strings are decoded from their index
+char *authTable[11];
+int authStringCounts[11];
+int authTabledUpTo = 0;
 int powie[11] = {1, 6, 36, 216, 1296, 7776, 46656, 279936, 1679616, 10077696, 60466176};
+int authLengthsReady = 0;
+pthread_mutex_t authMutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t authCond = PTHREAD_COND_INITIALIZER;
+
+// checkpoint settings and overhead accounting
+bool checkpointEnabled = false;
+bool resumeFromCheckpoint = false;
+char checkpointPath[256];
+StepJournal *stepJournal = NULL;
+int replaySuppressCount = 0;
+unsigned long long replayUndockedDocks = 0;
+long long offlineMessagesSent = 0;
+
+// live stats segment, NULL unless the scheduler was started with --stats-key
+PortStats *portStats = NULL;
+int statsShmId = -1;
+int statsKey = -1;
+long long stepPhaseNs[NUM_PHASES];
+
+// solver engines: one blocking thread per solver queue, or one event loop driving all of them
+#define SOLVER_ENGINE_THREADED 0
+#define SOLVER_ENGINE_EVLOOP 1
+#define EVLOOP_SPIN_PASSES 64
+#define EVLOOP_YIELD_PASSES 64
+#define EVLOOP_MAX_SLEEP_NS 200000
+int solverEngine = SOLVER_ENGINE_THREADED;
+long long solverGuessesTotal = 0;
+long long solverUndocks = 0;
+long long solverCpuUs = 0;
+long long solverContextSwitches = 0;
+long long solverInvoluntarySwitches = 0;
+long long solverMigrations = 0;
+long long solverWallNs = 0;
+
+// thread placement, all off unless asked for on the command line. solver i runs on
+// solverCpuSets[i % numSolverCpuSets]; with numa-local stacks each solver thread runs on
+// a stack kept for its solver and bound to the memory node of its cpus
+#define SOLVER_STACK_SIZE (256 * 1024)
+cpu_set_t originalCpus;
+cpu_set_t mainCpus;
+bool mainPinned = false;
+cpu_set_t *solverCpuSets;
+int numSolverCpuSets = 0;
+bool numaLocalStacks = false;
+int realtimePriority = 0;
+char **solverStacks;
+
+// rolling-horizon dock planner, off unless --plan-horizon is given
+#define PLAN_WAIT -1
+#define PLAN_GREEDY -2
+int planHorizon = 0;
+int *planAvailableAt;
+int *plannedDock;
+int *planCandidates;
+
+// free docks, i.e. neither occupied nor reserved, as a bitmap over the docks sorted by
+// category and then index. the smallest free dock of at least some category is the first
+// set bit from where that category starts, and the validator's dock limit fits in one word
+int *dockRank;
+int *dockAtRank;
+int *categoryStartRank;
+int maxDockCategory = 0;
+unsigned long long *freeDockBits;
+int freeDockWords = 0;
+
+// incoming emergencies wait in their own FIFO lane instead of the ships array, so they are
+// never sorted with everyone else and are only looked at when one arrives or a dock big
+// enough for one of them frees up
+Ship *emergencyLane;
+int laneCount = 0;
+int laneCapacity = 0;
+int laneMinCategory = INT_MAX;
+bool laneWakeup = false;
+char *checkpointBuffer = NULL;
+size_t checkpointBufferSize = 0;
+int checkpointsWritten = 0;
+long long checkpointTotalNs = 0;
+long long checkpointMaxNs = 0;
+
+// memory accounting: every heap allocation of the scheduler goes through the sched*
+// wrappers below, tagged with the subsystem that owns it. with --mem-budget the total is
+// capped and the optional auth tables are only built while they fit
+#define MEM_SHIPS 0
+#define MEM_DOCKS 1
+#define MEM_CARGO 2
+#define MEM_SOLVER 3
+#define MEM_AUTH 4
+#define MEM_CHECKPOINT 5
+#define NUM_MEM_TAGS 6
+#define MEM_HEADER_SIZE 16
+#define AUTH_BUDGET_RESERVE 4
+const char *memTagNames[NUM_MEM_TAGS] = {"ships", "docks", "cargo", "solver", "auth", "checkpoint"};
+long long memInUse[NUM_MEM_TAGS];
+long long memPeak[NUM_MEM_TAGS];
+long long memTotalInUse = 0;
+long long memTotalPeak = 0;
+long long memoryBudget = 0;
+
+long long monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// phase timing for the stats segment; clock_gettime goes through the vDSO, so this
+// costs no syscall, and nothing at all when stats are off
+long long statsClock()
+{
+    return portStats != NULL ? monotonicNs() : 0;
+}
+
+void recordPhase(int phase, long long *start)
+{
+    if (portStats == NULL)
+        return;
+
+    long long now = monotonicNs();
+    stepPhaseNs[phase] += now - *start;
+    *start = now;
+}
+
+// writers bracket every multi-field update so readers can tell when they copied a torn view
+void beginStatsUpdate()
+{
+    __atomic_store_n(&portStats->sequence, portStats->sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void endStatsUpdate()
+{
+    __atomic_store_n(&portStats->sequence, portStats->sequence + 1, __ATOMIC_RELEASE);
+}
+
+// here we are raising a peak counter, other threads may be raising it at the same time
+void raiseMemoryPeak(long long *peak, long long value)
+{
+    long long seen = __atomic_load_n(peak, __ATOMIC_RELAXED);
+    while (value > seen && !__atomic_compare_exchange_n(peak, &seen, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+}
+
+// here we are adding an allocation change to its subsystem and the total. the auth warmup
+// thread allocates while the main loop runs, so the counters are atomic
+void accountMemory(int tag, long long delta)
+{
+    long long inUse = __atomic_add_fetch(&memInUse[tag], delta, __ATOMIC_RELAXED);
+    long long total = __atomic_add_fetch(&memTotalInUse, delta, __ATOMIC_RELAXED);
+    raiseMemoryPeak(&memPeak[tag], inUse);
+    raiseMemoryPeak(&memTotalPeak, total);
+}
+
+// running out of budget is a configuration error, not something the scheduler can recover from
+void checkMemoryBudget(int tag, long long growth)
+{
+    if (memoryBudget <= 0 || growth <= 0)
+        return;
+
+    long long total = __atomic_load_n(&memTotalInUse, __ATOMIC_RELAXED);
+    if (total + growth > memoryBudget)
+    {
+        fprintf(stderr, "Memory budget of %.1f MB exceeded: %s needs %lld more bytes with %.1f MB in use\n",
+                memoryBudget / 1048576.0, memTagNames[tag], growth, total / 1048576.0);
+        exit(EXIT_FAILURE);
+    }
+}
+
+// every block carries its size in a header in front of it, so frees and reallocs can be
+// accounted without the caller passing sizes around
+void *schedMalloc(int tag, size_t size)
+{
+    checkMemoryBudget(tag, (long long)(size + MEM_HEADER_SIZE));
+
+    char *block = (char *)malloc(size + MEM_HEADER_SIZE);
+    if (block == NULL)
+        return NULL;
+
+    *(size_t *)block = size;
+    accountMemory(tag, (long long)(size + MEM_HEADER_SIZE));
+    return block + MEM_HEADER_SIZE;
+}
+
+void *schedCalloc(int tag, size_t count, size_t size)
+{
+    void *ptr = schedMalloc(tag, count * size);
+    if (ptr != NULL)
+        memset(ptr, 0, count * size);
+    return ptr;
+}
+
+void *schedRealloc(int tag, void *ptr, size_t size)
+{
+    if (ptr == NULL)
+        return schedMalloc(tag, size);
+
+    char *block = (char *)ptr - MEM_HEADER_SIZE;
+    size_t oldSize = *(size_t *)block;
+    checkMemoryBudget(tag, (long long)size - (long long)oldSize);
+
+    char *grown = (char *)realloc(block, size + MEM_HEADER_SIZE);
+    if (grown == NULL)
+        return NULL;
+
+    *(size_t *)grown = size;
+    accountMemory(tag, (long long)size - (long long)oldSize);
+    return grown + MEM_HEADER_SIZE;
+}
+
+void schedFree(int tag, void *ptr)
+{
+    if (ptr == NULL)
+        return;
+
+    char *block = (char *)ptr - MEM_HEADER_SIZE;
+    accountMemory(tag, -(long long)(*(size_t *)block + MEM_HEADER_SIZE));
+    free(block);
+}
+
+// here we are printing what every subsystem holds, and at exit also the most it ever held
+void printMemoryReport(const char *title, bool withPeaks)
+{
+    if (memoryBudget > 0)
+        fprintf(stderr, "%s, budget %.1f MB:\n", title, memoryBudget / 1048576.0);
+    else
+        fprintf(stderr, "%s, no budget:\n", title);
+
+    fprintf(stderr, "  %-12s %12s", "subsystem", "in use KB");
+    if (withPeaks)
+        fprintf(stderr, " %12s", "peak KB");
+    fprintf(stderr, "\n");
+
+    for (int tag = 0; tag < NUM_MEM_TAGS; tag++)
+    {
+        fprintf(stderr, "  %-12s %12.1f", memTagNames[tag], memInUse[tag] / 1024.0);
+        if (withPeaks)
+            fprintf(stderr, " %12.1f", memPeak[tag] / 1024.0);
+        fprintf(stderr, "\n");
+    }
+
+    fprintf(stderr, "  %-12s %12.1f", "total", memTotalInUse / 1024.0);
+    if (withPeaks)
+        fprintf(stderr, " %12.1f", memTotalPeak / 1024.0);
+    fprintf(stderr, "\n");
+}
 
 // to set up shared memory
 void SharedMemory(int key)
@@ -133,6 +479,19 @@ void SharedMemory(int key)
         exit(EXIT_FAILURE);
     }
 
+    struct shmid_ds info;
+    if (shmctl(shmId, IPC_STAT, &info) == -1)
+    {
+        perror("shmctl failed");
+        exit(EXIT_FAILURE);
+    }
+    if (info.shm_segsz < sizeof(MainSharedMemory))
+    {
+        fprintf(stderr, "Shared memory segment is %zu bytes, expected at least %zu\n",
+                (size_t)info.shm_segsz, sizeof(MainSharedMemory));
+        exit(EXIT_FAILURE);
+    }
+
     shmPtr = (MainSharedMemory *)shmat(shmId, NULL, 0);
     if (shmPtr == (MainSharedMemory *)-1)
     {
@@ -144,6 +503,13 @@ void SharedMemory(int key)
 // set up message queues
 void MessageQueues(int mainQueueKey, int solverQueueKeys[], int numSolvers)
 {
+    solverMsgQueueIds = (int *)schedMalloc(MEM_SOLVER, numSolvers * sizeof(int));
+    if (solverMsgQueueIds == NULL)
+    {
+        perror("Failed to allocate memory for solver queues");
+        exit(EXIT_FAILURE);
+    }
+
     mainMsgQueueId = msgget(mainQueueKey, 0666);
     if (mainMsgQueueId == -1)
     {
@@ -162,17 +528,141 @@ void MessageQueues(int mainQueueKey, int solverQueueKeys[], int numSolvers)
     }
 }
 
+// here we are sending a message to the validator on the main queue. while a step is being
+// replayed after a resume, messages the validator already got before the crash are skipped.
+// docking and cargo messages replay identically from the checkpoint, so counting them is
+// enough; undocks depend on solver answers and are journaled per dock instead
+int sendToMainQueue(MessageStruct *msg)
+{
+#ifdef SCHEDULER_OFFLINE
+    // offline tools run the scheduling kernels without a validator on the other end
+    (void)msg;
+    offlineMessagesSent++;
+    return 0;
+#else
+    if (stepJournal == NULL || msg->mtype == 3)
+    {
+        return msgsnd(mainMsgQueueId, msg, sizeof(MessageStruct) - sizeof(long), 0);
+    }
+
+    if (stepJournal->messagesSent < replaySuppressCount)
+    {
+        stepJournal->messagesSent++;
+        return 0;
+    }
+
+    int result = msgsnd(mainMsgQueueId, msg, sizeof(MessageStruct) - sizeof(long), 0);
+    if (result == 0)
+    {
+        stepJournal->messagesSent++;
+    }
+    return result;
+#endif
+}
+
+// here we are checking, without writing to it, whether an existing segment is a stats
+// segment whose scheduler is gone
+bool statsSegmentAbandoned(int shmId)
+{
+    struct shmid_ds info;
+    if (shmctl(shmId, IPC_STAT, &info) == -1 || info.shm_segsz < sizeof(PortStats))
+        return false;
+
+    PortStats *stale = (PortStats *)shmat(shmId, NULL, SHM_RDONLY);
+    if (stale == (PortStats *)-1)
+        return false;
+
+    bool abandoned = __atomic_load_n(&stale->magic, __ATOMIC_ACQUIRE) == PORT_STATS_MAGIC &&
+                     stale->schedulerPid > 0 && kill(stale->schedulerPid, 0) == -1 && errno == ESRCH;
+    shmdt(stale);
+    return abandoned;
+}
+
+// here we are creating the stats segment. we only ever write to a segment we created: one
+// left behind by a scheduler that died is removed and made again, anything else on the key
+// belongs to someone else and we stop
+void StatsSharedMemory(int key)
+{
+    size_t size = portStatsSize(numSolvers, numDocks);
+
+    statsShmId = shmget(key, size, IPC_CREAT | IPC_EXCL | 0666);
+    if (statsShmId == -1 && errno == EEXIST)
+    {
+        int staleId = shmget(key, 0, 0);
+        if (staleId == -1 || !statsSegmentAbandoned(staleId))
+        {
+            fprintf(stderr, "Stats key %d is in use by a segment this scheduler does not own, pick another --stats-key\n", key);
+            exit(EXIT_FAILURE);
+        }
+        if (shmctl(staleId, IPC_RMID, NULL) == -1)
+        {
+            perror("shmctl failed removing abandoned stats segment");
+            exit(EXIT_FAILURE);
+        }
+        fprintf(stderr, "Removed stats segment left behind by a previous scheduler on key %d\n", key);
+        statsShmId = shmget(key, size, IPC_CREAT | IPC_EXCL | 0666);
+    }
+    if (statsShmId == -1)
+    {
+        perror("shmget failed for stats segment");
+        exit(EXIT_FAILURE);
+    }
+
+    portStats = (PortStats *)shmat(statsShmId, NULL, 0);
+    if (portStats == (PortStats *)-1)
+    {
+        perror("shmat failed for stats segment");
+        exit(EXIT_FAILURE);
+    }
+
+    memset(portStats, 0, size);
+    portStats->version = PORT_STATS_VERSION;
+    portStats->schedulerPid = getpid();
+    portStats->numSolvers = numSolvers;
+    portStats->numDocks = numDocks;
+    portStats->mainQueueId = mainMsgQueueId;
+    portStats->undockDockId = -1;
+
+    SolverQueueStats *solverStats = portStatsSolvers(portStats);
+    for (int i = 0; i < numSolvers; i++)
+    {
+        solverStats[i].queueId = solverMsgQueueIds[i];
+    }
+
+    DockStats *dockStats = portStatsDocks(portStats);
+    for (int i = 0; i < numDocks; i++)
+    {
+        dockStats[i].category = docks[i].category;
+        dockStats[i].shipId = -1;
+    }
+
+    // readers check the magic last, so they never see a half initialized segment
+    __atomic_store_n(&portStats->magic, PORT_STATS_MAGIC, __ATOMIC_RELEASE);
+}
+
+// here we are detaching and removing the stats segment at exit; portStats is only set
+// once StatsSharedMemory has created the segment itself, so it is always ours to remove
+void releaseStatsSharedMemory()
+{
+    if (portStats == NULL)
+        return;
+
+    shmdt(portStats);
+    shmctl(statsShmId, IPC_RMID, NULL);
+    portStats = NULL;
+}
+
 // This part computes all possible authentication strings using these rules:
 // The first and last characters must be from {'5','6','7','8','9'}, and any middle characters (if any) must be from {'5','6','7','8','9','.'}. 
-// It uses a recursive approach to generate these strings, stores them in a precomputed 3D array (precomputedStrings), and tracks the count for each length in `authStringCounts`.
-void generateAuthStringRecursive(char *current, int pos, int length, char *FirstAndLast, char *middleChars, char **output, int *index)
+// It uses a recursive approach to generate these strings, stores them in one flat table per length (authTable) with a stride of length + 1, and tracks the count for each length in `authStringCounts`.
+void generateAuthStringRecursive(char *current, int pos, int length, char *FirstAndLast, char *middleChars, char *output, int *index)
 {
     if (pos == length - 1)
     {   
         for (int i = 0; i < 5; i++)
         {
             current[pos] = FirstAndLast[i];
-            strcpy(output[*index], current);
+            memcpy(output + (size_t)*index * (length + 1), current, length + 1);
             (*index)++;
         }
     }
@@ -188,7 +678,7 @@ void generateAuthStringRecursive(char *current, int pos, int length, char *First
 }
 
 // here we are generating auth string of specific lengths
-void generateAuthStringsOfLength(int length, char *FirstAndLast, char *middleChars, char **output)
+void generateAuthStringsOfLength(int length, char *FirstAndLast, char *middleChars, char *output)
 {
     int index = 0;
     if (length == 2)
@@ -197,16 +687,16 @@ void generateAuthStringsOfLength(int length, char *FirstAndLast, char *middleCha
         {
             for (int j = 0; j < 5; j++)
             {
-                output[index][0] = FirstAndLast[i];
-                output[index][1] = FirstAndLast[j];
-                output[index][2] = '\0';
+                output[index * 3] = FirstAndLast[i];
+                output[index * 3 + 1] = FirstAndLast[j];
+                output[index * 3 + 2] = '\0';
                 index++;
             }
         }
     }
     else
     {
-        char *currentString = (char *)malloc((length + 1) * sizeof(char));
+        char *currentString = (char *)schedMalloc(MEM_AUTH, (length + 1) * sizeof(char));
         currentString[length] = '\0';
         for (int i = 0; i < 5; i++)
         {
@@ -214,64 +704,193 @@ void generateAuthStringsOfLength(int length, char *FirstAndLast, char *middleCha
             generateAuthStringRecursive(currentString, 1, length, FirstAndLast, middleChars, output, &index);
         }
 
-        free(currentString);
+        schedFree(MEM_AUTH, currentString);
     }
 }
 
-// here we are precomputing all the auth strings
-void precomputeAuthStrings()
+// here we are writing the string at the given index of the generation order without any
+// table: the first character varies slowest and the last one fastest, so the index is
+// read back as first, then the middle characters in base 6, then last in base 5
+void decodeAuthString(int length, int index, char *out)
 {
-    authStringCounts = (int *)malloc(11 * sizeof(int));
-    precomputedStrings = (char ***)malloc(11 * sizeof(char **));
+    static const char FirstAndLast[] = "56789";
+    static const char middleChars[] = "56789.";
 
-    char FirstAndLast[] = "56789";
-    char middleChars[] = "56789.";
+    out[length] = '\0';
+    if (length == 1)
+    {
+        out[0] = FirstAndLast[index];
+        return;
+    }
+
+    out[length - 1] = FirstAndLast[index % 5];
+    index /= 5;
+    for (int pos = length - 2; pos >= 1; pos--)
+    {
+        out[pos] = middleChars[index % 6];
+        index /= 6;
+    }
+    out[0] = FirstAndLast[index];
+}
 
+// here we are fetching one auth string for a solver, from the table if its length has one
+void copyAuthString(int length, int index, char *out)
+{
+    if (authTable[length] != NULL)
+    {
+        memcpy(out, authTable[length] + (size_t)index * (length + 1), length + 1);
+        return;
+    }
+    decodeAuthString(length, index, out);
+}
+
+// here we are counting the strings of every length and deciding which lengths get a table.
+// tables are an optional speedup, so under a budget they are given to the shortest lengths
+// while they fit and still leave a quarter of the budget for ships and cargo yet to arrive
+void planAuthTables()
+{
+    long long available = LLONG_MAX;
+    if (memoryBudget > 0)
+        available = memoryBudget - memoryBudget / AUTH_BUDGET_RESERVE - memTotalInUse;
+
+    authTabledUpTo = 0;
     for (int length = 1; length <= 10; length++)
     {
-        int numOfCombination;
-        if (length == 1)
-        {
-            numOfCombination = 5;
-        }
-        else
+        authStringCounts[length] = length == 1 ? 5 : 5 * powie[length - 2] * 5;
+
+        long long tableBytes = (long long)authStringCounts[length] * (length + 1) + MEM_HEADER_SIZE;
+        if (authTabledUpTo == length - 1 && tableBytes <= available)
         {
-            numOfCombination = 5 * powie[length - 2] * 5;
+            authTabledUpTo = length;
+            available -= tableBytes;
         }
+    }
+}
+
+void printAuthPlan()
+{
+    long long tableBytes = 0;
+    for (int length = 1; length <= authTabledUpTo; length++)
+    {
+        tableBytes += (long long)authStringCounts[length] * (length + 1) + MEM_HEADER_SIZE;
+    }
 
-        authStringCounts[length] = numOfCombination;
+    if (authTabledUpTo == 10)
+        fprintf(stderr, "Auth strings: every length in tables, %.1f MB\n", tableBytes / 1048576.0);
+    else if (authTabledUpTo == 0)
+        fprintf(stderr, "Auth strings: every length decoded per guess\n");
+    else
+        fprintf(stderr, "Auth strings: lengths 1-%d in tables (%.1f MB), %d-10 decoded per guess\n",
+                authTabledUpTo, tableBytes / 1048576.0, authTabledUpTo + 1);
+}
 
-        precomputedStrings[length] = (char **)malloc(numOfCombination * sizeof(char *));
+// here we are building the table of one length, if it was planned
+void buildAuthStringsOfLength(int length)
+{
+    char FirstAndLast[] = "56789";
+    char middleChars[] = "56789.";
 
-        for (int i = 0; i < numOfCombination; i++)
-        {
-            precomputedStrings[length][i] = (char *)malloc((length + 1) * sizeof(char));
-        }
+    if (length > authTabledUpTo)
+        return;
 
-        int index = 0;
+    char *table = (char *)schedMalloc(MEM_AUTH, (size_t)authStringCounts[length] * (length + 1));
+    if (table == NULL)
+    {
+        // decoding gives the same strings, just a little slower per guess
+        fprintf(stderr, "Failed to allocate the length %d auth table, decoding instead\n", length);
+        authTabledUpTo = length - 1;
+        return;
+    }
 
-        if (length == 1)
-        {
-            for (int i = 0; i < 5; i++)
-            {
-                precomputedStrings[length][index][0] = FirstAndLast[i];
-                precomputedStrings[length][index][1] = '\0';
-                index++;
-            }
-        }
-        else
+    if (length == 1)
+    {
+        for (int i = 0; i < 5; i++)
         {
-            generateAuthStringsOfLength(length, FirstAndLast, middleChars, precomputedStrings[length]);
+            table[i * 2] = FirstAndLast[i];
+            table[i * 2 + 1] = '\0';
         }
     }
+    else
+    {
+        generateAuthStringsOfLength(length, FirstAndLast, middleChars, table);
+    }
+
+    authTable[length] = table;
+}
+
+// here we are marking one more length as usable by the solvers
+void publishAuthStringsOfLength(int length)
+{
+    pthread_mutex_lock(&authMutex);
+    authLengthsReady = length;
+    pthread_cond_broadcast(&authCond);
+    pthread_mutex_unlock(&authMutex);
+}
+
+// here we are precomputing the auth tables picked by planAuthTables
+void precomputeAuthStrings()
+{
+    for (int length = 1; length <= 10; length++)
+    {
+        buildAuthStringsOfLength(length);
+        publishAuthStringsOfLength(length);
+    }
+}
+
+// here we are freeing the auth tables at exit
+void releaseAuthStrings()
+{
+    for (int length = 1; length <= 10; length++)
+    {
+        schedFree(MEM_AUTH, authTable[length]);
+        authTable[length] = NULL;
+    }
+}
+
+// on resume we don't want to wait seconds for the full table before rejoining,
+// so it is built in the background, shortest lengths first
+void *authWarmupThread(void *arg)
+{
+    (void)arg;
+    precomputeAuthStrings();
+    return NULL;
+}
+
+// here we are waiting until the strings of the given length are built
+void waitForAuthStrings(int length)
+{
+    pthread_mutex_lock(&authMutex);
+    while (authLengthsReady < length)
+    {
+        pthread_cond_wait(&authCond, &authMutex);
+    }
+    pthread_mutex_unlock(&authMutex);
+}
+
+// here we are allocating the crane capacities and usage stamps of a dock
+void allocateCranes(Dock *dock)
+{
+    dock->craneCapacities = (int *)schedMalloc(MEM_DOCKS, dock->category * sizeof(int));
+    dock->craneUsedEpoch = (int *)schedCalloc(MEM_DOCKS, dock->category, sizeof(int));
+    if (dock->craneCapacities == NULL || dock->craneUsedEpoch == NULL)
+    {
+        perror("Failed to allocate memory for crane capacities");
+        exit(EXIT_FAILURE);
+    }
 }
 
 // here we are initializing docks from input
 void initializeDocks(FILE *inputFile)
 {
     fscanf(inputFile, "%d", &numDocks);
+    if (numDocks < 1 || numDocks > MAX_DOCKS)
+    {
+        fprintf(stderr, "Input has %d docks, the validator's shared memory has auth string slots for 1 to %d\n",
+                numDocks, MAX_DOCKS);
+        exit(EXIT_FAILURE);
+    }
 
-    docks = (Dock *)malloc(numDocks * sizeof(Dock));
+    docks = (Dock *)schedMalloc(MEM_DOCKS, numDocks * sizeof(Dock));
     if (docks == NULL)
     {
         perror("Failed to allocate memory for docks");
@@ -282,92 +901,308 @@ void initializeDocks(FILE *inputFile)
     {
         docks[i].id = i;
         docks[i].occupied = false;
+        docks[i].reserved = false;
 
         fscanf(inputFile, "%d", &docks[i].category);
-
-        docks[i].craneCapacities = (int *)malloc(docks[i].category * sizeof(int));
-        if (docks[i].craneCapacities == NULL)
+        if (docks[i].category < 1)
         {
-            perror("Failed to allocate memory for crane capacities");
+            fprintf(stderr, "Dock %d has category %d, expected at least 1\n", i, docks[i].category);
             exit(EXIT_FAILURE);
         }
 
+        allocateCranes(&docks[i]);
+
         for (int j = 0; j < docks[i].category; j++)
         {
             fscanf(inputFile, "%d", &docks[i].craneCapacities[j]);
         }
 
         docks[i].remainingCargoWeights = NULL;
+        docks[i].cargoCapacity = 0;
     }
 }
 
-// here we are initializing ships
-void initializeShips()
+int compareDockRank(const void *a, const void *b)
 {
-    ships = (Ship *)malloc(MAX_SHIPS * sizeof(Ship));
-    if (ships == NULL)
-    {
-        perror("Failed to allocate memory for ships");
-        exit(EXIT_FAILURE);
-    }
+    int dockA = *(const int *)a;
+    int dockB = *(const int *)b;
 
-    for (int i = 0; i < MAX_SHIPS; i++)
-    {
-        ships[i].cargoWeights = (int *)malloc(MAX_CARGO_COUNT * sizeof(int));
-        if (ships[i].cargoWeights == NULL)
-        {
-            perror("Failed to allocate memory for cargo weights");
-            exit(EXIT_FAILURE);
-        }
-        ships[i].serviced = true;
-    }
+    if (docks[dockA].category != docks[dockB].category)
+        return docks[dockA].category - docks[dockB].category;
+    return dockA - dockB;
+}
+
+// here we are setting the free bit of one dock after its occupied or reserved flag changed
+void updateFreeDock(int dockIndex)
+{
+    int rank = dockRank[dockIndex];
+    unsigned long long bit = 1ULL << (rank % 64);
 
-    shipCapacity = MAX_SHIPS;
+    if (!docks[dockIndex].occupied && !docks[dockIndex].reserved)
+        freeDockBits[rank / 64] |= bit;
+    else
+        freeDockBits[rank / 64] &= ~bit;
 }
 
-// here we are adding new ships
-void addShip(ShipRequest shipRequest)
+// here we are (re)building the free dock bitmap from the docks array
+void initializeFreeDocks()
 {
-    int index = -1;
+    schedFree(MEM_DOCKS, dockRank);
+    schedFree(MEM_DOCKS, dockAtRank);
+    schedFree(MEM_DOCKS, categoryStartRank);
+    schedFree(MEM_DOCKS, freeDockBits);
 
-    for (int i = 0; i < shipCount; i++)
+    maxDockCategory = 0;
+    for (int i = 0; i < numDocks; i++)
     {
-        if (ships[i].id == shipRequest.shipId && ships[i].direction == shipRequest.direction && !ships[i].serviced)
-        {
-            index = i;
+        if (docks[i].category > maxDockCategory)
+            maxDockCategory = docks[i].category;
+    }
+
+    freeDockWords = (numDocks + 63) / 64;
+    dockRank = (int *)schedMalloc(MEM_DOCKS, numDocks * sizeof(int));
+    dockAtRank = (int *)schedMalloc(MEM_DOCKS, numDocks * sizeof(int));
+    categoryStartRank = (int *)schedMalloc(MEM_DOCKS, (maxDockCategory + 1) * sizeof(int));
+    freeDockBits = (unsigned long long *)schedCalloc(MEM_DOCKS, freeDockWords, sizeof(unsigned long long));
+    if (dockRank == NULL || dockAtRank == NULL || categoryStartRank == NULL || freeDockBits == NULL)
+    {
+        perror("Failed to allocate memory for free docks");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < numDocks; i++)
+    {
+        dockAtRank[i] = i;
+    }
+    qsort(dockAtRank, numDocks, sizeof(int), compareDockRank);
+
+    int rank = 0;
+    for (int category = 0; category <= maxDockCategory; category++)
+    {
+        while (docks[dockAtRank[rank]].category < category)
+            rank++;
+        categoryStartRank[category] = rank;
+    }
+
+    for (int r = 0; r < numDocks; r++)
+    {
+        dockRank[dockAtRank[r]] = r;
+    }
+    for (int i = 0; i < numDocks; i++)
+    {
+        updateFreeDock(i);
+    }
+}
+
+// here we are finding the smallest free dock of at least the given category, lowest index
+// first among equals, or -1
+int findFreeDock(int category)
+{
+    if (category > maxDockCategory)
+        return -1;
+    if (category < 0)
+        category = 0;
+
+    int rank = categoryStartRank[category];
+    int word = rank / 64;
+    unsigned long long bits = freeDockBits[word] & (~0ULL << (rank % 64));
+
+    while (bits == 0)
+    {
+        if (++word == freeDockWords)
+            return -1;
+        bits = freeDockBits[word];
+    }
+
+    return dockAtRank[word * 64 + __builtin_ctzll(bits)];
+}
+
+// here we are making sure a cargo buffer holds the given number of weights. buffers stay
+// with their dock or ship slot and only grow to the largest load they have seen, so steady
+// state docking does no allocation at all
+int *reserveCargoBuffer(int *buffer, int *capacity, int numCargo)
+{
+    if (numCargo < 1)
+        numCargo = 1;
+    if (buffer != NULL && numCargo <= *capacity)
+        return buffer;
+
+    int *grown = (int *)schedRealloc(MEM_CARGO, buffer, numCargo * sizeof(int));
+    if (grown == NULL)
+    {
+        perror("Failed to allocate memory for cargo weights");
+        exit(EXIT_FAILURE);
+    }
+    *capacity = numCargo;
+    return grown;
+}
+
+// here we are doubling the ships array, and the planner's per-ship arrays with it
+void growShips()
+{
+    int newCapacity = shipCapacity > 0 ? shipCapacity * 2 : INITIAL_SHIP_CAPACITY;
+
+    Ship *grown = (Ship *)schedRealloc(MEM_SHIPS, ships, newCapacity * sizeof(Ship));
+    if (grown == NULL)
+    {
+        perror("Failed to allocate memory for ships");
+        exit(EXIT_FAILURE);
+    }
+    ships = grown;
+
+    for (int i = shipCapacity; i < newCapacity; i++)
+    {
+        ships[i].cargoWeights = NULL;
+        ships[i].cargoCapacity = 0;
+        ships[i].serviced = true;
+    }
+
+    if (plannedDock != NULL)
+    {
+        plannedDock = (int *)schedRealloc(MEM_SHIPS, plannedDock, newCapacity * sizeof(int));
+        planCandidates = (int *)schedRealloc(MEM_SHIPS, planCandidates, newCapacity * sizeof(int));
+        if (plannedDock == NULL || planCandidates == NULL)
+        {
+            perror("Failed to allocate memory for dock planner");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    shipCapacity = newCapacity;
+}
+
+// here we are initializing ships; the array starts small and grows as ships arrive
+void initializeShips()
+{
+    ships = NULL;
+    shipCapacity = 0;
+    growShips();
+}
+
+// here we are copying a ship request into a ship slot
+void fillShip(Ship *ship, ShipRequest *shipRequest)
+{
+    ship->id = shipRequest->shipId;
+    ship->direction = shipRequest->direction;
+    ship->category = shipRequest->category;
+    ship->emergency = shipRequest->emergency;
+    ship->waitingTime = shipRequest->waitingTime;
+    ship->arrivalTimestep = shipRequest->timestep;
+    ship->numCargo = shipRequest->numCargo;
+    ship->docked = false;
+    ship->serviced = false;
+    ship->remainingCargo = shipRequest->numCargo;
+
+    if (ship->direction == 1 && ship->emergency == 0)
+    {
+        ship->deadline = ship->arrivalTimestep + ship->waitingTime;
+    }
+    else
+    {
+        ship->deadline = INT_MAX;
+    }
+
+    ship->cargoWeights = reserveCargoBuffer(ship->cargoWeights, &ship->cargoCapacity, shipRequest->numCargo);
+    for (int i = 0; i < shipRequest->numCargo; i++)
+    {
+        ship->cargoWeights[i] = shipRequest->cargo[i];
+    }
+}
+
+// here we are taking one more slot at the back of the emergency lane
+Ship *appendToEmergencyLane()
+{
+    if (laneCount == laneCapacity)
+    {
+        int newCapacity = laneCapacity > 0 ? laneCapacity * 2 : 8;
+        Ship *grown = (Ship *)schedRealloc(MEM_SHIPS, emergencyLane, newCapacity * sizeof(Ship));
+        if (grown == NULL)
+        {
+            perror("Failed to allocate memory for emergency lane");
+            exit(EXIT_FAILURE);
+        }
+        emergencyLane = grown;
+
+        for (int i = laneCapacity; i < newCapacity; i++)
+        {
+            emergencyLane[i].cargoWeights = NULL;
+            emergencyLane[i].cargoCapacity = 0;
+        }
+        laneCapacity = newCapacity;
+    }
+
+    return &emergencyLane[laneCount++];
+}
+
+// here we are queueing an incoming emergency, or updating it if it is already waiting
+void enqueueEmergency(ShipRequest *shipRequest)
+{
+    Ship *ship = NULL;
+    for (int i = 0; i < laneCount; i++)
+    {
+        if (emergencyLane[i].id == shipRequest->shipId && emergencyLane[i].direction == shipRequest->direction)
+        {
+            ship = &emergencyLane[i];
             break;
         }
     }
 
-    if (index == -1)
+    if (ship == NULL)
     {
-        index = shipCount++;
+        ship = appendToEmergencyLane();
     }
 
-    ships[index].id = shipRequest.shipId;
-    ships[index].direction = shipRequest.direction;
-    ships[index].category = shipRequest.category;
-    ships[index].emergency = shipRequest.emergency;
-    ships[index].waitingTime = shipRequest.waitingTime;
-    ships[index].arrivalTimestep = shipRequest.timestep;
-    ships[index].numCargo = shipRequest.numCargo;
-    ships[index].docked = false;
-    ships[index].serviced = false;
-    ships[index].remainingCargo = shipRequest.numCargo;
+    fillShip(ship, shipRequest);
+
+    if (ship->category < laneMinCategory)
+        laneMinCategory = ship->category;
+    laneWakeup = true;
+}
+
+// here we are checking whether a request goes on the emergency lane instead of the ships array
+bool isIncomingEmergency(const ShipRequest *shipRequest)
+{
+    return shipRequest->direction == 1 && shipRequest->emergency == 1;
+}
 
-    if (ships[index].direction == 1 && ships[index].emergency == 0)
+// here we are adding new ships. incoming emergencies go straight to the lane, so taking
+// one in never walks the ships array
+void addShip(ShipRequest shipRequest)
+{
+    if (shipRequest.numCargo < 0 || shipRequest.numCargo > MAX_CARGO_COUNT)
     {
-        ships[index].deadline = ships[index].arrivalTimestep + ships[index].waitingTime;
+        fprintf(stderr, "Ship %d has %d cargo items, at most %d fit in shared memory\n",
+                shipRequest.shipId, shipRequest.numCargo, MAX_CARGO_COUNT);
+        exit(EXIT_FAILURE);
     }
-    else
+
+    if (isIncomingEmergency(&shipRequest))
+    {
+        enqueueEmergency(&shipRequest);
+        return;
+    }
+
+    int index = -1;
+
+    for (int i = 0; i < shipCount; i++)
     {
-        ships[index].deadline = INT_MAX;
+        if (ships[i].id == shipRequest.shipId && ships[i].direction == shipRequest.direction && !ships[i].serviced)
+        {
+            index = i;
+            break;
+        }
     }
 
-    for (int i = 0; i < shipRequest.numCargo; i++)
+    if (index == -1)
     {
-        ships[index].cargoWeights[i] = shipRequest.cargo[i];
+        if (shipCount == shipCapacity)
+        {
+            growShips();
+        }
+        index = shipCount++;
     }
+
+    fillShip(&ships[index], &shipRequest);
 }
 
 // here we are comparing ships by their priority
@@ -401,26 +1236,246 @@ int compareShipPriority(const void *a, const void *b)
 
 // here we are searching for the best dock for the given shipindex
 int GetBestDock(int shipIndex)
+{
+    return findFreeDock(ships[shipIndex].category);
+}
+
+// here we are ordering ships strictly by arrival, emergencies still go first
+int compareShipArrival(const void *a, const void *b)
+{
+    const Ship *shipA = (const Ship *)a;
+    const Ship *shipB = (const Ship *)b;
+
+    if (shipA->serviced || shipA->docked)
+        return 1;
+    if (shipB->serviced || shipB->docked)
+        return -1;
+
+    if (shipA->emergency != shipB->emergency)
+        return shipB->emergency - shipA->emergency;
+
+    return shipA->arrivalTimestep - shipB->arrivalTimestep;
+}
+
+int compareIntDescending(const void *a, const void *b)
+{
+    return *(const int *)b - *(const int *)a;
+}
+
+// here we are estimating how many timesteps the cranes of a dock need to move the given
+// cargo; weights of 0 are items that were already moved. every crane moves at most one
+// item per timestep, so for each weight w the items at least that heavy have to share the
+// cranes that can lift w. walking both lists heaviest first gives both counts without
+// comparing every pair
+int estimateSpanOfWeights(const int *cargoWeights, int numCargo, int dockIndex)
+{
+    int category = docks[dockIndex].category;
+
+    int weights[MAX_CARGO_COUNT];
+    int capacities[category];
+    int numWeights = 0;
+    for (int i = 0; i < numCargo; i++)
+    {
+        if (cargoWeights[i] > 0)
+            weights[numWeights++] = cargoWeights[i];
+    }
+    memcpy(capacities, docks[dockIndex].craneCapacities, category * sizeof(int));
+    qsort(weights, numWeights, sizeof(int), compareIntDescending);
+    qsort(capacities, category, sizeof(int), compareIntDescending);
+
+    int span = 0;
+    int cranes = 0;
+    for (int i = 0; i < numWeights; i++)
+    {
+        while (cranes < category && capacities[cranes] >= weights[i])
+            cranes++;
+
+        if (cranes == 0)
+            return INT_MAX;
+
+        int needed = (i + 1 + cranes - 1) / cranes;
+        if (needed > span)
+            span = needed;
+    }
+
+    return span;
+}
+
+int estimateCargoSpan(int shipIndex, int dockIndex)
+{
+    return estimateSpanOfWeights(ships[shipIndex].cargoWeights, ships[shipIndex].numCargo, dockIndex);
+}
+
+// here we are searching for the free dock that finishes the given ship's cargo soonest,
+// preferring the smaller category when two docks are equally fast
+int GetFastestDock(int shipIndex)
 {
     int bestDock = -1;
+    int bestSpan = INT_MAX;
     int bestCategory = INT_MAX;
     int shipCategory = ships[shipIndex].category;
 
     for (int i = 0; i < numDocks; i++)
     {
-        if (!docks[i].occupied && docks[i].category >= shipCategory)
+        if (docks[i].occupied || docks[i].reserved || docks[i].category < shipCategory)
+            continue;
+
+        int span = estimateCargoSpan(shipIndex, i);
+        if (span < bestSpan || (span == bestSpan && docks[i].category < bestCategory))
         {
-            if (docks[i].category < bestCategory)
-            {
-                bestCategory = docks[i].category;
-                bestDock = i;
-            }
+            bestSpan = span;
+            bestCategory = docks[i].category;
+            bestDock = i;
         }
     }
 
     return bestDock;
 }
 
+// incoming ships that waited past their deadline are never docked
+bool shipWithinDeadline(int shipIndex)
+{
+    return !(ships[shipIndex].direction == 1 && ships[shipIndex].emergency == 0 &&
+             currentTimestep > ships[shipIndex].deadline);
+}
+
+SchedulingPolicy schedulingPolicies[] = {
+    {"greedy", compareShipPriority, GetBestDock, shipWithinDeadline},
+    {"fifo", compareShipArrival, GetBestDock, shipWithinDeadline},
+    {"fastdock", compareShipPriority, GetFastestDock, shipWithinDeadline},
+};
+int numSchedulingPolicies = sizeof(schedulingPolicies) / sizeof(schedulingPolicies[0]);
+
+#ifdef SCHEDULER_POLICY_RUNTIME
+SchedulingPolicy *activePolicy = &schedulingPolicies[SCHEDULER_POLICY];
+#define policyCompareShips activePolicy->compareShips
+#define policySelectDock activePolicy->selectDock
+#define policyAdmitShip activePolicy->admitShip
+#elif SCHEDULER_POLICY == POLICY_FIFO
+#define policyCompareShips compareShipArrival
+#define policySelectDock GetBestDock
+#define policyAdmitShip shipWithinDeadline
+#elif SCHEDULER_POLICY == POLICY_FASTDOCK
+#define policyCompareShips compareShipPriority
+#define policySelectDock GetFastestDock
+#define policyAdmitShip shipWithinDeadline
+#else
+#define policyCompareShips compareShipPriority
+#define policySelectDock GetBestDock
+#define policyAdmitShip shipWithinDeadline
+#endif
+
+// here we are allocating the planner's per-dock and per-ship scratch arrays
+void initializePlanner()
+{
+    planAvailableAt = (int *)schedMalloc(MEM_DOCKS, numDocks * sizeof(int));
+    plannedDock = (int *)schedMalloc(MEM_SHIPS, shipCapacity * sizeof(int));
+    planCandidates = (int *)schedMalloc(MEM_SHIPS, shipCapacity * sizeof(int));
+    if (planAvailableAt == NULL || plannedDock == NULL || planCandidates == NULL)
+    {
+        perror("Failed to allocate memory for dock planner");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// here we are projecting the first timestep a new ship could dock at the given dock.
+// cargo moves after docking within a timestep and undocking comes last, so a ship docked
+// at t with a span of s cargo steps leaves at t + s + 1 and the dock is usable at t + s + 2
+int projectedDockFree(int dockIndex)
+{
+    Dock *dock = &docks[dockIndex];
+    if (!dock->occupied)
+        return currentTimestep;
+
+    if (dock->remainingCargo == 0)
+        return currentTimestep + 1;
+
+    int cargoSteps = estimateSpanOfWeights(dock->remainingCargoWeights, dock->numCargo, dockIndex);
+    if (cargoSteps == INT_MAX)
+        return INT_MAX;
+
+    int firstCargoStep = dock->dockingTimestep == currentTimestep ? currentTimestep + 1 : currentTimestep;
+    return firstCargoStep + cargoSteps + 1;
+}
+
+int compareCandidateDeadline(const void *a, const void *b)
+{
+    const Ship *shipA = &ships[*(const int *)a];
+    const Ship *shipB = &ships[*(const int *)b];
+
+    if (shipA->deadline != shipB->deadline)
+        return shipA->deadline < shipB->deadline ? -1 : 1;
+    return *(const int *)a - *(const int *)b;
+}
+
+// here we are planning docks for incoming ships whose deadline falls inside the horizon.
+// they are taken earliest deadline first, and each gets the smallest dock category that
+// is projected to be free before its deadline, so a ship that can wait a step for a small
+// dock doesn't take the large one a tighter ship will need. the chosen dock is then
+// projected busy for the ship's estimated cargo span. ships planned for a dock that is
+// free now reserve it for this timestep; everyone else docks greedily on unreserved docks
+void planDocking()
+{
+    for (int d = 0; d < numDocks; d++)
+    {
+        docks[d].reserved = false;
+        updateFreeDock(d);
+        planAvailableAt[d] = projectedDockFree(d);
+    }
+
+    int numCandidates = 0;
+    for (int i = 0; i < shipCount; i++)
+    {
+        plannedDock[i] = PLAN_GREEDY;
+
+        if (!ships[i].docked && !ships[i].serviced && ships[i].direction == 1 && ships[i].emergency == 0 &&
+            ships[i].deadline <= currentTimestep + planHorizon && policyAdmitShip(i))
+        {
+            planCandidates[numCandidates++] = i;
+        }
+    }
+
+    qsort(planCandidates, numCandidates, sizeof(int), compareCandidateDeadline);
+
+    for (int c = 0; c < numCandidates; c++)
+    {
+        int shipIndex = planCandidates[c];
+        int bestDock = -1;
+
+        for (int d = 0; d < numDocks; d++)
+        {
+            if (docks[d].category < ships[shipIndex].category || planAvailableAt[d] > ships[shipIndex].deadline)
+                continue;
+
+            if (bestDock == -1 || docks[d].category < docks[bestDock].category ||
+                (docks[d].category == docks[bestDock].category && planAvailableAt[d] < planAvailableAt[bestDock]))
+            {
+                bestDock = d;
+            }
+        }
+
+        if (bestDock == -1)
+            continue;
+
+        int span = estimateCargoSpan(shipIndex, bestDock);
+        if (span == INT_MAX)
+            continue;
+
+        if (planAvailableAt[bestDock] == currentTimestep && !docks[bestDock].occupied)
+        {
+            plannedDock[shipIndex] = bestDock;
+            docks[bestDock].reserved = true;
+            updateFreeDock(bestDock);
+        }
+        else
+        {
+            plannedDock[shipIndex] = PLAN_WAIT;
+        }
+
+        planAvailableAt[bestDock] += span + 2;
+    }
+}
+
 // here we are docking the ship
 void dockShip(int shipIndex, int dockIndex)
 {
@@ -431,7 +1486,7 @@ void dockShip(int shipIndex, int dockIndex)
     msg.direction = ships[shipIndex].direction;
     msg.dockId = docks[dockIndex].id;
 
-    if (msgsnd(mainMsgQueueId, &msg, sizeof(MessageStruct) - sizeof(long), 0) == -1)
+    if (sendToMainQueue(&msg) == -1)
     {
         perror("msgsnd failed for docking");
         exit(EXIT_FAILURE);
@@ -440,17 +1495,16 @@ void dockShip(int shipIndex, int dockIndex)
     ships[shipIndex].docked = true;
     ships[shipIndex].dockId = docks[dockIndex].id;
     docks[dockIndex].occupied = true;
+    updateFreeDock(dockIndex);
     docks[dockIndex].shipId = ships[shipIndex].id;
     docks[dockIndex].direction = ships[shipIndex].direction;
     docks[dockIndex].dockingTimestep = currentTimestep;
     docks[dockIndex].remainingCargo = ships[shipIndex].numCargo;
+    docks[dockIndex].numCargo = ships[shipIndex].numCargo;
 
-    docks[dockIndex].remainingCargoWeights = (int *)malloc(ships[shipIndex].numCargo * sizeof(int));
-    if (docks[dockIndex].remainingCargoWeights == NULL)
-    {
-        perror("Failed to allocate memory for remaining cargo weights");
-        exit(EXIT_FAILURE);
-    }
+    docks[dockIndex].remainingCargoWeights = reserveCargoBuffer(docks[dockIndex].remainingCargoWeights,
+                                                                &docks[dockIndex].cargoCapacity,
+                                                                ships[shipIndex].numCargo);
 
     for (int i = 0; i < ships[shipIndex].numCargo; i++)
     {
@@ -458,24 +1512,48 @@ void dockShip(int shipIndex, int dockIndex)
     }
 }
 
-// here we are processing emergency ships
-bool processEmergencyShips()
+// here we are docking waiting emergencies, in arrival order, on the best fitting free dock.
+// a docked emergency moves from the lane to the back of the ships array; the rest keep
+// their order. nothing is scanned unless an emergency arrived or a dock that fits one freed
+bool dispatchEmergencyLane()
 {
+    if (!laneWakeup)
+        return false;
+    laneWakeup = false;
+
     bool anyEmergencyShipDocked = false;
+    int kept = 0;
+    laneMinCategory = INT_MAX;
 
-    for (int i = 0; i < shipCount; i++)
+    for (int i = 0; i < laneCount; i++)
     {
-        if (!ships[i].docked && !ships[i].serviced && ships[i].direction == 1 && ships[i].emergency == 1)
+        Ship waiting = emergencyLane[i];
+        int dockIndex = findFreeDock(waiting.category);
+
+        if (dockIndex != -1)
         {
-            int dockIndex = GetBestDock(i);
-            if (dockIndex != -1)
+            if (shipCount == shipCapacity)
             {
-                dockShip(i, dockIndex);
-                anyEmergencyShipDocked = true;
+                growShips();
             }
+
+            // swapping keeps every cargo buffer owned by exactly one slot
+            int shipIndex = shipCount++;
+            emergencyLane[i] = ships[shipIndex];
+            ships[shipIndex] = waiting;
+            dockShip(shipIndex, dockIndex);
+            anyEmergencyShipDocked = true;
+        }
+        else
+        {
+            emergencyLane[i] = emergencyLane[kept];
+            emergencyLane[kept++] = waiting;
+            if (waiting.category < laneMinCategory)
+                laneMinCategory = waiting.category;
         }
     }
 
+    laneCount = kept;
     return anyEmergencyShipDocked;
 }
 
@@ -516,7 +1594,7 @@ bool moveCargo(int dockIndex)
 
         for (int craneId = 0; craneId < docks[dockIndex].category; craneId++)
         {
-            if (craneUsedTimestep[dockIndex][craneId])
+            if (docks[dockIndex].craneUsedEpoch[craneId] == craneEpoch)
                 continue;
 
             int capacity = docks[dockIndex].craneCapacities[craneId];
@@ -540,9 +1618,9 @@ bool moveCargo(int dockIndex)
             msg.dockId = docks[dockIndex].id;
             msg.cargoId = cargoId;
             msg.craneId = bestCrane;
-            msgsnd(mainMsgQueueId, &msg, sizeof(MessageStruct) - sizeof(long), 0);
+            sendToMainQueue(&msg);
 
-            craneUsedTimestep[dockIndex][bestCrane] = true;
+            docks[dockIndex].craneUsedEpoch[bestCrane] = craneEpoch;
             docks[dockIndex].remainingCargoWeights[cargoId] = 0;
             docks[dockIndex].remainingCargo--;
             docks[dockIndex].lastCargoMovedTimestep = currentTimestep;
@@ -554,194 +1632,1396 @@ bool moveCargo(int dockIndex)
     return false;
 }
 
-/* now for solver we have a 3d character array of precomputed strings whose 1st parameter is string length, 2nd parameter is no of combinations and 3rd is string length +1 where we are storing all the combinations character wise 
-so by using multithreding we will divide that character array in no. of combinations/no. of solvers, give each section to one solver and then we will search for the auth string */
-// here we are starting the thread for solver process
-void *startSolverThread(void *arg)
+// here we are reading a cpu list like "2,4-7" into a set. every cpu in it has to be one
+// this process is allowed to run on
+bool parseCpuList(const char *text, cpu_set_t *set)
 {
-    SolverThreadData *data = (SolverThreadData *)arg;
-    int dockIndex = data->dockIndex;
-    int solverId = data->solverId;
-    bool *guessedCorrectly = data->guessedCorrectly;
-    char *correctAuthString = data->correctAuthString;
-    pthread_mutex_t *mutex = data->mutex;
-    pthread_cond_t *cond = data->cond;
+    CPU_ZERO(set);
+    const char *p = text;
 
-    int stringLength = docks[dockIndex].lastCargoMovedTimestep - docks[dockIndex].dockingTimestep;
-    if (stringLength <= 0 || stringLength > 10)
+    while (*p != '\0')
     {
-        pthread_exit(NULL);
-    }
+        char *end;
+        long first = strtol(p, &end, 10);
+        if (end == p || first < 0)
+            return false;
 
-    SolverRequest req;
-    req.mtype = 1;
-    req.dockId = docks[dockIndex].id;
+        long last = first;
+        if (*end == '-')
+        {
+            p = end + 1;
+            last = strtol(p, &end, 10);
+            if (end == p || last < first)
+                return false;
+        }
 
-    if (msgsnd(solverMsgQueueIds[solverId], &req, sizeof(SolverRequest) - sizeof(long), 0) == -1)
-    {
-        perror("msgsnd failed for solver notification");
-        pthread_exit(NULL);
+        if (last >= CPU_SETSIZE)
+            return false;
+        for (long cpu = first; cpu <= last; cpu++)
+        {
+            if (!CPU_ISSET(cpu, &originalCpus))
+                return false;
+            CPU_SET(cpu, set);
+        }
+
+        if (*end == ',')
+            end++;
+        else if (*end != '\0')
+            return false;
+        p = end;
     }
 
-    int totalCombinations = authStringCounts[stringLength];
-    int combPerThread = (totalCombinations + numSolvers - 1) / numSolvers;
-    int startIndex = solverId * combPerThread;
-    int endIndex = (solverId + 1) * combPerThread;
+    return CPU_COUNT(set) > 0;
+}
 
-    if (endIndex > totalCombinations)
-        endIndex = totalCombinations;
+// here we are writing a cpu set back as a list for the startup report
+void formatCpuSet(cpu_set_t *set, char *out, size_t size)
+{
+    size_t used = 0;
+    out[0] = '\0';
 
-    for (int i = startIndex; i < endIndex; i++)
+    for (int cpu = 0; cpu < CPU_SETSIZE && used < size; cpu++)
     {
-        pthread_mutex_lock(mutex);
-        if (*guessedCorrectly)
-        {
-            pthread_mutex_unlock(mutex);
-            break;
+        if (!CPU_ISSET(cpu, set))
+            continue;
+
+        int last = cpu;
+        while (last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, set))
+            last++;
+
+        if (last == cpu)
+            used += snprintf(out + used, size - used, "%s%d", used > 0 ? "," : "", cpu);
+        else
+            used += snprintf(out + used, size - used, "%s%d-%d", used > 0 ? "," : "", cpu, last);
+        cpu = last;
+    }
+}
+
+// here we are finding the memory node of the first cpu in a set, or -1 without NUMA info
+int cpuSetNode(cpu_set_t *set)
+{
+    int cpu = 0;
+    while (cpu < CPU_SETSIZE && !CPU_ISSET(cpu, set))
+        cpu++;
+
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+    DIR *dir = opendir(path);
+    if (dir == NULL)
+        return -1;
+
+    int node = -1;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (strncmp(entry->d_name, "node", 4) == 0 && sscanf(entry->d_name + 4, "%d", &node) == 1)
+            break;
+    }
+    closedir(dir);
+    return node;
+}
+
+// here we are mapping the stack one solver's threads run on. nothing is touched yet, and the
+// range prefers the node of the solver's cpus, so its pages land next to the thread using
+// them even on the first fault. a PROT_NONE page below it catches overflows like a normal
+// thread stack's guard page would
+char *allocateSolverStack(cpu_set_t *cpus)
+{
+    long pageSize = sysconf(_SC_PAGESIZE);
+    checkMemoryBudget(MEM_SOLVER, SOLVER_STACK_SIZE + pageSize);
+
+    char *mapping = (char *)mmap(NULL, SOLVER_STACK_SIZE + pageSize, PROT_READ | PROT_WRITE,
+                                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if (mapping == MAP_FAILED)
+    {
+        perror("mmap failed for solver stack");
+        exit(EXIT_FAILURE);
+    }
+    mprotect(mapping, pageSize, PROT_NONE);
+    accountMemory(MEM_SOLVER, SOLVER_STACK_SIZE + pageSize);
+
+    // without NUMA support this fails and the pages are simply placed on first touch
+    int node = cpuSetNode(cpus);
+    if (node >= 0 && node < (int)(8 * sizeof(unsigned long)))
+    {
+        unsigned long nodeMask = 1UL << node;
+        syscall(SYS_mbind, mapping + pageSize, SOLVER_STACK_SIZE, MPOL_PREFERRED, &nodeMask,
+                8 * sizeof(nodeMask), 0);
+    }
+
+    return mapping + pageSize;
+}
+
+// here we are applying the placement options: pin the main thread, check the solver cpu
+// sets, map numa-local solver stacks and switch to realtime priority. cpus are validated
+// against the mask the process started with, which is also what solver threads get when
+// only the main thread is pinned
+void configureThreadPlacement(const char *mainCpuList, const char *solverCpuLists)
+{
+    // the event loop searches from the main thread, so there are no solver threads to place
+    if (solverEngine == SOLVER_ENGINE_EVLOOP && (solverCpuLists != NULL || numaLocalStacks))
+    {
+        fprintf(stderr, "--solver-cpus and --numa-local place solver threads, which --solver-engine evloop does not start; pin the event loop with --main-cpus\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (sched_getaffinity(0, sizeof(originalCpus), &originalCpus) == -1)
+    {
+        perror("sched_getaffinity failed");
+        exit(EXIT_FAILURE);
+    }
+
+    if (mainCpuList != NULL)
+    {
+        if (!parseCpuList(mainCpuList, &mainCpus))
+        {
+            fprintf(stderr, "Invalid --main-cpus %s, expected a list like 0 or 0-1 of cpus this process may use\n",
+                    mainCpuList);
+            exit(EXIT_FAILURE);
+        }
+        if (sched_setaffinity(0, sizeof(mainCpus), &mainCpus) == -1)
+        {
+            perror("sched_setaffinity failed for main thread");
+            exit(EXIT_FAILURE);
+        }
+        mainPinned = true;
+    }
+
+    if (solverCpuLists != NULL)
+    {
+        numSolverCpuSets = 1;
+        for (const char *c = solverCpuLists; *c != '\0'; c++)
+        {
+            if (*c == ':')
+                numSolverCpuSets++;
+        }
+
+        solverCpuSets = (cpu_set_t *)schedMalloc(MEM_SOLVER, numSolverCpuSets * sizeof(cpu_set_t));
+        size_t listsSize = strlen(solverCpuLists) + 1;
+        char *lists = (char *)schedMalloc(MEM_SOLVER, listsSize);
+        if (solverCpuSets == NULL || lists == NULL)
+        {
+            perror("Failed to allocate memory for solver cpu sets");
+            exit(EXIT_FAILURE);
+        }
+        memcpy(lists, solverCpuLists, listsSize);
+
+        char *list = lists;
+        for (int i = 0; i < numSolverCpuSets; i++)
+        {
+            char *next = strchr(list, ':');
+            if (next != NULL)
+                *next = '\0';
+
+            if (!parseCpuList(list, &solverCpuSets[i]))
+            {
+                fprintf(stderr, "Invalid --solver-cpus set %s, expected lists like 2-3:4-5 of cpus this process may use\n",
+                        list);
+                exit(EXIT_FAILURE);
+            }
+            if (next != NULL)
+                list = next + 1;
+        }
+        schedFree(MEM_SOLVER, lists);
+    }
+
+    if (numaLocalStacks)
+    {
+        if (numSolverCpuSets == 0)
+        {
+            fprintf(stderr, "--numa-local needs --solver-cpus to know which node each solver runs on\n");
+            exit(EXIT_FAILURE);
+        }
+
+        solverStacks = (char **)schedMalloc(MEM_SOLVER, numSolvers * sizeof(char *));
+        if (solverStacks == NULL)
+        {
+            perror("Failed to allocate memory for solver stacks");
+            exit(EXIT_FAILURE);
+        }
+        for (int i = 0; i < numSolvers; i++)
+        {
+            solverStacks[i] = allocateSolverStack(&solverCpuSets[i % numSolverCpuSets]);
+        }
+    }
+
+    // without the privilege for it we carry on at normal priority rather than refuse to run
+    if (realtimePriority > 0)
+    {
+        struct sched_param param = {.sched_priority = realtimePriority};
+        if (sched_setscheduler(0, SCHED_FIFO, &param) == -1)
+        {
+            fprintf(stderr, "Realtime priority %d not available (%s), running at normal priority\n",
+                    realtimePriority, strerror(errno));
+            realtimePriority = 0;
+        }
+    }
+}
+
+// here we are unmapping the numa-local solver stacks at exit
+void releaseSolverStacks()
+{
+    if (solverStacks == NULL)
+        return;
+
+    long pageSize = sysconf(_SC_PAGESIZE);
+    for (int i = 0; i < numSolvers; i++)
+    {
+        munmap(solverStacks[i] - pageSize, SOLVER_STACK_SIZE + pageSize);
+        accountMemory(MEM_SOLVER, -(SOLVER_STACK_SIZE + pageSize));
+    }
+    schedFree(MEM_SOLVER, solverStacks);
+    solverStacks = NULL;
+}
+
+void printThreadPlacement()
+{
+    if (!mainPinned && numSolverCpuSets == 0 && realtimePriority == 0)
+        return;
+
+    char cpus[256];
+    fprintf(stderr, "Thread placement:");
+    if (mainPinned)
+    {
+        formatCpuSet(&mainCpus, cpus, sizeof(cpus));
+        fprintf(stderr, " main on cpus %s", cpus);
+    }
+    for (int i = 0; i < numSolverCpuSets && i < numSolvers; i++)
+    {
+        formatCpuSet(&solverCpuSets[i], cpus, sizeof(cpus));
+        fprintf(stderr, "%s %s", i == 0 ? (mainPinned ? ", solvers on" : " solvers on") : " |", cpus);
+    }
+    if (numaLocalStacks)
+        fprintf(stderr, ", numa-local solver stacks");
+    if (realtimePriority > 0)
+        fprintf(stderr, ", SCHED_FIFO priority %d", realtimePriority);
+    fprintf(stderr, "\n");
+}
+
+// here we are setting where and how a solver thread runs. with no placement options the
+// attributes are left alone and the thread inherits from the main thread as before; with
+// only the main thread pinned, solvers get the cpus the process started with instead
+void setSolverThreadPlacement(pthread_attr_t *attr, int solverId)
+{
+    if (numSolverCpuSets > 0)
+        pthread_attr_setaffinity_np(attr, sizeof(cpu_set_t), &solverCpuSets[solverId % numSolverCpuSets]);
+    else if (mainPinned)
+        pthread_attr_setaffinity_np(attr, sizeof(cpu_set_t), &originalCpus);
+
+    if (realtimePriority > 0)
+    {
+        struct sched_param param = {.sched_priority = realtimePriority};
+        pthread_attr_setinheritsched(attr, PTHREAD_EXPLICIT_SCHED);
+        pthread_attr_setschedpolicy(attr, SCHED_FIFO);
+        pthread_attr_setschedparam(attr, &param);
+    }
+
+    if (numaLocalStacks)
+        pthread_attr_setstack(attr, solverStacks[solverId], SOLVER_STACK_SIZE);
+}
+
+// here we are counting it when the calling thread was moved to another cpu since the last look
+void trackCpuMigration(int *lastCpu, long long *migrations)
+{
+    int cpu = sched_getcpu();
+    if (cpu != *lastCpu)
+    {
+        if (*lastCpu != -1)
+            (*migrations)++;
+        *lastCpu = cpu;
+    }
+}
+
+// here we are counting one answered guess for the engine report and the stats segment
+void countSolverGuess(int solverId)
+{
+    __atomic_add_fetch(&solverGuessesTotal, 1, __ATOMIC_RELAXED);
+    if (portStats != NULL)
+    {
+        __atomic_add_fetch(&portStatsSolvers(portStats)[solverId].guesses, 1, __ATOMIC_RELAXED);
+    }
+}
+
+/* now for solver every auth string of a length has an index: copyAuthString takes it from the flat per-length authTable, or decodes it from the index when that length was not tabled under the memory budget
+so by using multithreding we will divide the index range in no. of combinations/no. of solvers, give each section to one solver and then we will search for the auth string */
+// here we are searching this solver's share of the strings for one undock
+void searchSolverShare(SolverThreadData *data)
+{
+    int dockIndex = data->dockIndex;
+    int solverId = data->solverId;
+    bool *guessedCorrectly = data->guessedCorrectly;
+    char *correctAuthString = data->correctAuthString;
+    pthread_mutex_t *mutex = data->mutex;
+    pthread_cond_t *cond = data->cond;
+
+    int stringLength = docks[dockIndex].lastCargoMovedTimestep - docks[dockIndex].dockingTimestep;
+    if (stringLength <= 0 || stringLength > 10)
+    {
+        return;
+    }
+
+    SolverRequest req;
+    req.mtype = 1;
+    req.dockId = docks[dockIndex].id;
+
+    if (msgsnd(solverMsgQueueIds[solverId], &req, sizeof(SolverRequest) - sizeof(long), 0) == -1)
+    {
+        perror("msgsnd failed for solver notification");
+        return;
+    }
+
+    int totalCombinations = authStringCounts[stringLength];
+    int combPerThread = (totalCombinations + numSolvers - 1) / numSolvers;
+    int startIndex = solverId * combPerThread;
+    int endIndex = (solverId + 1) * combPerThread;
+
+    if (endIndex > totalCombinations)
+        endIndex = totalCombinations;
+
+    int lastCpu = -1;
+    for (int i = startIndex; i < endIndex; i++)
+    {
+        trackCpuMigration(&lastCpu, &data->migrations);
+
+        pthread_mutex_lock(mutex);
+        if (*guessedCorrectly)
+        {
+            pthread_mutex_unlock(mutex);
+            break;
+        }
+        pthread_mutex_unlock(mutex);
+
+        char authString[MAX_AUTH_STRING_LEN];
+        copyAuthString(stringLength, i, authString);
+
+        req.mtype = 2;
+        strcpy(req.authStringGuess, authString);
+
+        if (msgsnd(solverMsgQueueIds[solverId], &req, sizeof(SolverRequest) - sizeof(long), 0) == -1)
+        {
+            perror("msgsnd failed for solver guess");
+            return;
+        }
+
+        SolverResponse resp;
+        if (msgrcv(solverMsgQueueIds[solverId], &resp, sizeof(SolverResponse) - sizeof(long), 3, 0) == -1)
+        {
+            perror("msgrcv failed for solver response");
+            return;
+        }
+
+        countSolverGuess(solverId);
+
+        if (resp.guessIsCorrect == 1)
+        {
+            pthread_mutex_lock(mutex);
+            *guessedCorrectly = true;
+            strcpy(correctAuthString, authString);
+            pthread_cond_broadcast(cond);
+            pthread_mutex_unlock(mutex);
+            break;
+        }
+        else if (resp.guessIsCorrect == -1)
+        {
+            pthread_mutex_lock(mutex);
+            *guessedCorrectly = true;
+            pthread_cond_broadcast(cond);
+            pthread_mutex_unlock(mutex);
+            return;
+        }
+    }
+}
+
+// here we are starting the thread for solver process; it keeps its own cpu time and
+// context switches so the engine report does not count anything else in the process
+void *startSolverThread(void *arg)
+{
+    SolverThreadData *data = (SolverThreadData *)arg;
+    searchSolverShare(data);
+    getrusage(RUSAGE_THREAD, &data->usage);
+    return NULL;
+}
+
+// here we are adding what a thread used between two getrusage(RUSAGE_THREAD) samples to the
+// engine report; a thread started for the search passes NULL for the first sample
+void addSolverUsage(const struct rusage *before, const struct rusage *after)
+{
+    struct rusage zero;
+    if (before == NULL)
+    {
+        memset(&zero, 0, sizeof(zero));
+        before = &zero;
+    }
+
+    solverCpuUs += (after->ru_utime.tv_sec - before->ru_utime.tv_sec) * 1000000LL +
+                   (after->ru_utime.tv_usec - before->ru_utime.tv_usec) +
+                   (after->ru_stime.tv_sec - before->ru_stime.tv_sec) * 1000000LL +
+                   (after->ru_stime.tv_usec - before->ru_stime.tv_usec);
+    solverContextSwitches += (after->ru_nvcsw - before->ru_nvcsw) + (after->ru_nivcsw - before->ru_nivcsw);
+    solverInvoluntarySwitches += after->ru_nivcsw - before->ru_nivcsw;
+}
+
+// here we are searching with one blocking thread per solver queue
+bool runSolverThreads(int dockIndex, char *correctAuthString)
+{
+    bool guessedCorrectly = false;
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+
+    pthread_t threads[numSolvers];
+    SolverThreadData threadData[numSolvers];
+
+    for (int i = 0; i < numSolvers; i++)
+    {
+        threadData[i].dockIndex = dockIndex;
+        threadData[i].solverId = i;
+        threadData[i].guessedCorrectly = &guessedCorrectly;
+        threadData[i].correctAuthString = correctAuthString;
+        threadData[i].mutex = &mutex;
+        threadData[i].cond = &cond;
+        threadData[i].migrations = 0;
+
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        setSolverThreadPlacement(&attr, i);
+        int created = pthread_create(&threads[i], &attr, startSolverThread, &threadData[i]);
+        pthread_attr_destroy(&attr);
+        if (created != 0)
+        {
+            // the threads already running would keep searching on stacks the next undock
+            // reuses, so tell them to stop and wait for them before giving up
+            fprintf(stderr, "Failed to create solver thread: %s\n", strerror(created));
+            pthread_mutex_lock(&mutex);
+            guessedCorrectly = true;
+            pthread_cond_broadcast(&cond);
+            pthread_mutex_unlock(&mutex);
+            for (int j = 0; j < i; j++)
+            {
+                pthread_join(threads[j], NULL);
+                solverMigrations += threadData[j].migrations;
+                addSolverUsage(NULL, &threadData[j].usage);
+            }
+            pthread_mutex_destroy(&mutex);
+            pthread_cond_destroy(&cond);
+            return false;
+        }
+    }
+
+    pthread_mutex_lock(&mutex);
+    if (!guessedCorrectly)
+    {
+        pthread_cond_wait(&cond, &mutex);
+    }
+    pthread_mutex_unlock(&mutex);
+
+    for (int i = 0; i < numSolvers; i++)
+    {
+        pthread_join(threads[i], NULL);
+        solverMigrations += threadData[i].migrations;
+        addSolverUsage(NULL, &threadData[i].usage);
+    }
+
+    pthread_mutex_destroy(&mutex);
+    pthread_cond_destroy(&cond);
+
+    return guessedCorrectly;
+}
+
+#define SOLVER_NOTIFY 0
+#define SOLVER_SEND 1
+#define SOLVER_AWAIT 2
+#define SOLVER_DONE 3
+
+typedef struct SolverQueueState
+{
+    int phase;
+    int nextIndex;
+    int endIndex;
+    SolverRequest req;
+} SolverQueueState;
+
+// here we are searching with the calling thread driving every solver queue as a state
+// machine: notify, send a guess, wait for its answer, repeat. all queue operations are
+// IPC_NOWAIT, and each queue gets its next guess as soon as the previous answer lands.
+// when a pass over the queues makes no progress we spin, then yield, then sleep with
+// exponential backoff. once the string is found we stop sending but still collect the
+// answers to guesses in flight, so none of them is left behind for the next undock
+bool runSolverEventLoop(int dockIndex, int stringLength, char *correctAuthString)
+{
+    if (stringLength > 10)
+        return false;
+
+    SolverQueueState state[numSolvers];
+    int totalCombinations = authStringCounts[stringLength];
+    int combPerQueue = (totalCombinations + numSolvers - 1) / numSolvers;
+
+    for (int i = 0; i < numSolvers; i++)
+    {
+        state[i].phase = SOLVER_NOTIFY;
+        state[i].nextIndex = i * combPerQueue;
+        state[i].endIndex = (i + 1) * combPerQueue < totalCombinations ? (i + 1) * combPerQueue : totalCombinations;
+        state[i].req.mtype = 1;
+        state[i].req.dockId = docks[dockIndex].id;
+    }
+
+    bool found = false;
+    bool aborted = false;
+    int idlePasses = 0;
+    long long sleepNs = 1000;
+    int active = numSolvers;
+    int lastCpu = -1;
+
+    while (active > 0)
+    {
+        bool progress = false;
+        trackCpuMigration(&lastCpu, &solverMigrations);
+
+        for (int i = 0; i < numSolvers; i++)
+        {
+            SolverQueueState *queue = &state[i];
+
+            if ((found || aborted) && queue->phase != SOLVER_AWAIT && queue->phase != SOLVER_DONE)
+            {
+                queue->phase = SOLVER_DONE;
+                active--;
+                continue;
+            }
+
+            if (queue->phase == SOLVER_NOTIFY || queue->phase == SOLVER_SEND)
+            {
+                if (msgsnd(solverMsgQueueIds[i], &queue->req, sizeof(SolverRequest) - sizeof(long), IPC_NOWAIT) == -1)
+                {
+                    if (errno != EAGAIN && errno != EINTR)
+                    {
+                        perror("msgsnd failed for solver request");
+                        queue->phase = SOLVER_DONE;
+                        active--;
+                    }
+                    continue;
+                }
+
+                progress = true;
+                if (queue->phase == SOLVER_SEND)
+                {
+                    queue->phase = SOLVER_AWAIT;
+                }
+                else if (queue->nextIndex < queue->endIndex)
+                {
+                    queue->phase = SOLVER_SEND;
+                    queue->req.mtype = 2;
+                    copyAuthString(stringLength, queue->nextIndex, queue->req.authStringGuess);
+                }
+                else
+                {
+                    queue->phase = SOLVER_DONE;
+                    active--;
+                }
+            }
+            else if (queue->phase == SOLVER_AWAIT)
+            {
+                SolverResponse resp;
+                if (msgrcv(solverMsgQueueIds[i], &resp, sizeof(SolverResponse) - sizeof(long), 3, IPC_NOWAIT) == -1)
+                {
+                    if (errno != ENOMSG && errno != EINTR)
+                    {
+                        perror("msgrcv failed for solver response");
+                        queue->phase = SOLVER_DONE;
+                        active--;
+                    }
+                    continue;
+                }
+
+                progress = true;
+                countSolverGuess(i);
+
+                if (resp.guessIsCorrect == 1 && !found)
+                {
+                    found = true;
+                    strcpy(correctAuthString, queue->req.authStringGuess);
+                }
+                else if (resp.guessIsCorrect == -1)
+                {
+                    aborted = true;
+                }
+
+                queue->nextIndex++;
+                if (!found && !aborted && queue->nextIndex < queue->endIndex)
+                {
+                    // the next guess is ready to go out on this same pass
+                    queue->phase = SOLVER_SEND;
+                    copyAuthString(stringLength, queue->nextIndex, queue->req.authStringGuess);
+                    i--;
+                }
+                else
+                {
+                    queue->phase = SOLVER_DONE;
+                    active--;
+                }
+            }
+        }
+
+        if (progress)
+        {
+            idlePasses = 0;
+            sleepNs = 1000;
+        }
+        else if (++idlePasses <= EVLOOP_SPIN_PASSES)
+        {
+            // the answer is usually only a few microseconds away, so keep polling
+        }
+        else if (idlePasses <= EVLOOP_SPIN_PASSES + EVLOOP_YIELD_PASSES)
+        {
+            sched_yield();
+        }
+        else
+        {
+            struct timespec pause = {0, sleepNs};
+            nanosleep(&pause, NULL);
+            if (sleepNs < EVLOOP_MAX_SLEEP_NS)
+                sleepNs *= 2;
+        }
+    }
+
+    return found;
+}
+
+// here we are printing what the solver searches cost, so the engines can be compared
+void printSolverEngineReport()
+{
+    if (solverUndocks == 0)
+        return;
+
+    fprintf(stderr, "Solver engine %s: %lld undocks, %lld guesses, %.2f us cpu/guess, %.1f context switches/undock (%.1f involuntary), %.1f migrations/undock, %.2f ms/undock\n",
+            solverEngine == SOLVER_ENGINE_EVLOOP ? "evloop" : "threaded", solverUndocks, solverGuessesTotal,
+            solverGuessesTotal > 0 ? (double)solverCpuUs / solverGuessesTotal : 0.0,
+            (double)solverContextSwitches / solverUndocks, (double)solverInvoluntarySwitches / solverUndocks,
+            (double)solverMigrations / solverUndocks, solverWallNs / 1e6 / solverUndocks);
+}
+
+// here we are showing a solver search in the stats segment while it runs
+void publishUndockStart(int dockIndex, int stringLength)
+{
+    if (portStats == NULL)
+        return;
+
+    beginStatsUpdate();
+    portStats->undockInProgress = 1;
+    portStats->undockDockId = docks[dockIndex].id;
+    portStats->undockStringLength = stringLength;
+    for (int i = 0; i < numSolvers; i++)
+    {
+        portStatsSolvers(portStats)[i].busy = 1;
+    }
+    endStatsUpdate();
+}
+
+void publishUndockEnd(bool completed)
+{
+    if (portStats == NULL)
+        return;
+
+    beginStatsUpdate();
+    portStats->undockInProgress = 0;
+    if (completed)
+        portStats->undocksCompleted++;
+    for (int i = 0; i < numSolvers; i++)
+    {
+        portStatsSolvers(portStats)[i].busy = 0;
+    }
+    endStatsUpdate();
+}
+
+// here we are marking the ship at a dock serviced and the dock free
+void releaseDock(int dockIndex)
+{
+    for (int i = 0; i < shipCount; i++)
+    {
+        if (ships[i].id == docks[dockIndex].shipId && ships[i].direction == docks[dockIndex].direction)
+        {
+            ships[i].docked = false;
+            ships[i].serviced = true;
+            break;
+        }
+    }
+
+    docks[dockIndex].occupied = false;
+    updateFreeDock(dockIndex);
+
+    // a waiting emergency only gets another look once a dock it fits in is free
+    if (laneCount > 0 && docks[dockIndex].category >= laneMinCategory)
+    {
+        laneWakeup = true;
+    }
+}
+
+// here we are recording in the step journal that the validator has this dock's undock
+void journalUndock(int dockIndex)
+{
+#ifndef SCHEDULER_OFFLINE
+    if (stepJournal != NULL)
+    {
+        stepJournal->undockedDocks |= 1ULL << dockIndex;
+    }
+#else
+    (void)dockIndex;
+#endif
+}
+
+// here we are undocking the ship
+bool undockShip(int dockIndex)
+{
+    if (!docks[dockIndex].occupied || docks[dockIndex].remainingCargo > 0)
+    {
+        return false;
+    }
+
+    if (docks[dockIndex].lastCargoMovedTimestep == currentTimestep)
+    {
+        return false;
+    }
+
+    int stringLength = docks[dockIndex].lastCargoMovedTimestep - docks[dockIndex].dockingTimestep;
+    if (stringLength <= 0)
+        return false;
+
+    // on a replayed step, a dock whose undock the validator already received is only
+    // released again; searching would ask the solvers about a ship that has left
+    if (replayUndockedDocks & (1ULL << dockIndex))
+    {
+        journalUndock(dockIndex);
+        releaseDock(dockIndex);
+        return true;
+    }
+
+    if (stringLength <= 10)
+    {
+        waitForAuthStrings(stringLength);
+    }
+
+    char correctAuthString[MAX_AUTH_STRING_LEN];
+
+    publishUndockStart(dockIndex, stringLength);
+
+    // only the main thread is sampled here, the threaded engine adds its solver threads at
+    // join, so emulated solvers or other threads in the process never show up in the report
+    struct rusage usageBefore, usageAfter;
+    getrusage(RUSAGE_THREAD, &usageBefore);
+    long long searchStart = monotonicNs();
+
+    bool guessedCorrectly;
+    if (solverEngine == SOLVER_ENGINE_EVLOOP)
+        guessedCorrectly = runSolverEventLoop(dockIndex, stringLength, correctAuthString);
+    else
+        guessedCorrectly = runSolverThreads(dockIndex, correctAuthString);
+
+    solverWallNs += monotonicNs() - searchStart;
+    getrusage(RUSAGE_THREAD, &usageAfter);
+    solverUndocks++;
+    addSolverUsage(&usageBefore, &usageAfter);
+
+    publishUndockEnd(guessedCorrectly);
+
+    if (!guessedCorrectly)
+    {
+        return false;
+    }
+
+    strcpy(shmPtr->authStrings[docks[dockIndex].id], correctAuthString);
+
+    MessageStruct msg;
+    msg.mtype = 3;
+    msg.shipId = docks[dockIndex].shipId;
+    msg.direction = docks[dockIndex].direction;
+    msg.dockId = docks[dockIndex].id;
+
+    if (sendToMainQueue(&msg) == -1)
+    {
+        perror("msgsnd failed for undocking");
+        exit(EXIT_FAILURE);
+    }
+    journalUndock(dockIndex);
+
+    releaseDock(dockIndex);
+    return true;
+}
+
+// here we are running one timestep: take in the new requests from shared memory, dock,
+// move cargo and undock
+void processTimestep(int numNewRequests)
+{
+    long long phaseStart = statsClock();
+    craneEpoch++;
+
+    int regularArrivals = 0;
+    for (int i = 0; i < numNewRequests; i++)
+    {
+        if (!isIncomingEmergency(&shmPtr->newShipRequests[i]))
+            regularArrivals++;
+        addShip(shmPtr->newShipRequests[i]);
+    }
+    recordPhase(PHASE_INGEST, &phaseStart);
+
+    // an emergency docked from the lane lands at the back of the array, behind the ships
+    // still waiting, so only regular arrivals change the order
+    dispatchEmergencyLane();
+
+    if (regularArrivals > 0)
+    {
+        qsort(ships, shipCount, sizeof(Ship), policyCompareShips);
+    }
+
+    if (planHorizon > 0)
+    {
+        planDocking();
+    }
+
+    for (int i = 0; i < shipCount; i++)
+    {
+        if (!ships[i].docked && !ships[i].serviced)
+        {
+            if (!policyAdmitShip(i))
+            {
+                continue;
+            }
+
+            int dockIndex;
+            if (planHorizon > 0 && plannedDock[i] != PLAN_GREEDY)
+                dockIndex = plannedDock[i];
+            else
+                dockIndex = policySelectDock(i);
+
+            if (dockIndex != -1)
+            {
+                docks[dockIndex].reserved = false;
+                dockShip(i, dockIndex);
+            }
+        }
+    }
+    recordPhase(PHASE_DOCK, &phaseStart);
+
+    for (int dockIndex = 0; dockIndex < numDocks; dockIndex++)
+    {
+        while (moveCargo(dockIndex))
+        {
+            // Keep moving cargo from this dock until no more can be moved
+        }
+    }
+    recordPhase(PHASE_CARGO, &phaseStart);
+
+    for (int dockIndex = 0; dockIndex < numDocks; dockIndex++)
+    {
+        undockShip(dockIndex);
+    }
+    recordPhase(PHASE_UNDOCK, &phaseStart);
+}
+
+// here we are publishing ship counts, dock occupancy and phase timings at the end of a timestep
+void publishTimestepStats()
+{
+    if (portStats == NULL)
+        return;
+
+    int waiting = laneCount, docked = 0, serviced = 0, missed = 0, occupied = 0;
+    for (int i = 0; i < shipCount; i++)
+    {
+        if (ships[i].serviced)
+            serviced++;
+        else if (ships[i].docked)
+            docked++;
+        else if (!policyAdmitShip(i))
+            missed++;
+        else
+            waiting++;
+    }
+
+    beginStatsUpdate();
+    portStats->timestep = currentTimestep;
+    portStats->shipsWaiting = waiting;
+    portStats->shipsDocked = docked;
+    portStats->shipsServiced = serviced;
+    portStats->deadlineMisses = missed;
+
+    DockStats *dockStats = portStatsDocks(portStats);
+    for (int i = 0; i < numDocks; i++)
+    {
+        dockStats[i].occupied = docks[i].occupied;
+        dockStats[i].shipId = docks[i].occupied ? docks[i].shipId : -1;
+        dockStats[i].direction = docks[i].direction;
+        dockStats[i].remainingCargo = docks[i].occupied ? docks[i].remainingCargo : 0;
+        occupied += docks[i].occupied;
+    }
+    portStats->docksOccupied = occupied;
+
+    for (int phase = 0; phase < NUM_PHASES; phase++)
+    {
+        portStats->lastPhaseNs[phase] = stepPhaseNs[phase];
+        portStats->totalPhaseNs[phase] += stepPhaseNs[phase];
+        stepPhaseNs[phase] = 0;
+    }
+    endStatsUpdate();
+}
+
+// here we are making sure the checkpoint buffer can hold the given number of bytes
+void reserveCheckpointBuffer(size_t size)
+{
+    if (size <= checkpointBufferSize)
+        return;
+
+    char *grown = (char *)schedRealloc(MEM_CHECKPOINT, checkpointBuffer, size);
+    if (grown == NULL)
+    {
+        perror("Failed to allocate memory for checkpoint buffer");
+        exit(EXIT_FAILURE);
+    }
+    checkpointBuffer = grown;
+    checkpointBufferSize = size;
+}
+
+// here we are serializing one ship record followed by its cargo weights
+char *writeShipSnapshot(char *out, Ship *ship)
+{
+    ShipSnapshot snap;
+    snap.id = ship->id;
+    snap.direction = ship->direction;
+    snap.category = ship->category;
+    snap.emergency = ship->emergency;
+    snap.waitingTime = ship->waitingTime;
+    snap.arrivalTimestep = ship->arrivalTimestep;
+    snap.numCargo = ship->numCargo;
+    snap.docked = ship->docked;
+    snap.dockId = ship->dockId;
+    snap.serviced = ship->serviced;
+    snap.remainingCargo = ship->remainingCargo;
+    snap.deadline = ship->deadline;
+    memcpy(out, &snap, sizeof(snap));
+    out += sizeof(snap);
+
+    memcpy(out, ship->cargoWeights, snap.numCargo * sizeof(int));
+    return out + snap.numCargo * sizeof(int);
+}
+
+// here we are writing a snapshot of ships, docks and remaining cargo at a timestep boundary.
+// the snapshot is serialized into one buffer, written with a single write() to a temp file
+// and renamed over the previous one, so a crash never leaves a half written checkpoint behind.
+// returns false if the snapshot did not make it to disk, the previous checkpoint then stays
+bool writeCheckpoint()
+{
+    long long start = monotonicNs();
+
+    size_t size = sizeof(CheckpointHeader) + numDocks * sizeof(DockSnapshot) +
+                  (shipCount + laneCount) * sizeof(ShipSnapshot);
+    for (int i = 0; i < numDocks; i++)
+    {
+        if (docks[i].occupied)
+            size += docks[i].numCargo * sizeof(int);
+    }
+    for (int i = 0; i < shipCount; i++)
+    {
+        size += ships[i].numCargo * sizeof(int);
+    }
+    for (int i = 0; i < laneCount; i++)
+    {
+        size += emergencyLane[i].numCargo * sizeof(int);
+    }
+    reserveCheckpointBuffer(size);
+
+    char *out = checkpointBuffer;
+
+    CheckpointHeader header;
+    header.magic = CHECKPOINT_MAGIC;
+    header.version = CHECKPOINT_VERSION;
+    header.timestep = currentTimestep;
+    header.numDocks = numDocks;
+    header.shipCount = shipCount + laneCount;
+    memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+
+    for (int i = 0; i < numDocks; i++)
+    {
+        DockSnapshot snap;
+        snap.category = docks[i].category;
+        snap.occupied = docks[i].occupied;
+        snap.shipId = docks[i].shipId;
+        snap.direction = docks[i].direction;
+        snap.dockingTimestep = docks[i].dockingTimestep;
+        snap.lastCargoMovedTimestep = docks[i].lastCargoMovedTimestep;
+        snap.remainingCargo = docks[i].remainingCargo;
+        snap.numCargo = docks[i].occupied ? docks[i].numCargo : 0;
+        memcpy(out, &snap, sizeof(snap));
+        out += sizeof(snap);
+
+        if (snap.numCargo > 0)
+        {
+            memcpy(out, docks[i].remainingCargoWeights, snap.numCargo * sizeof(int));
+            out += snap.numCargo * sizeof(int);
+        }
+    }
+
+    // emergencies still in the lane are written as ordinary waiting ships after the rest
+    for (int i = 0; i < shipCount; i++)
+    {
+        out = writeShipSnapshot(out, &ships[i]);
+    }
+    for (int i = 0; i < laneCount; i++)
+    {
+        out = writeShipSnapshot(out, &emergencyLane[i]);
+    }
+
+    char tempPath[sizeof(checkpointPath) + 4];
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", checkpointPath);
+
+    int fd = open(tempPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1)
+    {
+        perror("open failed for checkpoint");
+        return false;
+    }
+
+    size_t written = 0;
+    while (written < size)
+    {
+        ssize_t n = write(fd, checkpointBuffer + written, size - written);
+        if (n == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            perror("write failed for checkpoint");
+            close(fd);
+            return false;
         }
-        pthread_mutex_unlock(mutex);
+        written += n;
+    }
+    close(fd);
 
-        char *authString = precomputedStrings[stringLength][i];
+    if (rename(tempPath, checkpointPath) == -1)
+    {
+        perror("rename failed for checkpoint");
+        return false;
+    }
 
-        req.mtype = 2;
-        strcpy(req.authStringGuess, authString);
+    long long elapsed = monotonicNs() - start;
+    checkpointsWritten++;
+    checkpointTotalNs += elapsed;
+    if (elapsed > checkpointMaxNs)
+        checkpointMaxNs = elapsed;
+    return true;
+}
 
-        if (msgsnd(solverMsgQueueIds[solverId], &req, sizeof(SolverRequest) - sizeof(long), 0) == -1)
-        {
-            perror("msgsnd failed for solver guess");
-            pthread_exit(NULL);
-        }
+// here we are mapping the step journal that sits next to the checkpoint file
+void mapStepJournal()
+{
+    char journalPath[sizeof(checkpointPath) + 8];
+    snprintf(journalPath, sizeof(journalPath), "%s.journal", checkpointPath);
 
-        SolverResponse resp;
-        if (msgrcv(solverMsgQueueIds[solverId], &resp, sizeof(SolverResponse) - sizeof(long), 3, 0) == -1)
-        {
-            perror("msgrcv failed for solver response");
-            pthread_exit(NULL);
-        }
+    int fd = open(journalPath, O_RDWR | O_CREAT, 0644);
+    if (fd == -1 || ftruncate(fd, sizeof(StepJournal)) == -1)
+    {
+        perror("Failed to open step journal");
+        exit(EXIT_FAILURE);
+    }
 
-        if (resp.guessIsCorrect == 1)
-        {
-            pthread_mutex_lock(mutex);
-            *guessedCorrectly = true;
-            strcpy(correctAuthString, authString);
-            pthread_cond_broadcast(cond);
-            pthread_mutex_unlock(mutex);
-            break;
-        }
-        else if (resp.guessIsCorrect == -1)
-        {
-            pthread_mutex_lock(mutex);
-            *guessedCorrectly = true;
-            pthread_cond_broadcast(cond);
-            pthread_mutex_unlock(mutex);
-            pthread_exit(NULL);
-        }
+    stepJournal = (StepJournal *)mmap(NULL, sizeof(StepJournal), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (stepJournal == MAP_FAILED)
+    {
+        perror("mmap failed for step journal");
+        exit(EXIT_FAILURE);
     }
+}
 
-    pthread_exit(NULL);
+// here we are recording that a new timestep has been received from the validator
+void beginStepJournal(int timestep, int numShipRequests)
+{
+    if (stepJournal == NULL)
+        return;
+
+    stepJournal->magic = CHECKPOINT_MAGIC;
+    stepJournal->timestep = timestep;
+    stepJournal->numShipRequests = numShipRequests;
+    stepJournal->messagesSent = 0;
+    stepJournal->undockedDocks = 0;
+    stepJournal->stepComplete = 0;
+    stepJournal->endOfStepSent = 0;
 }
 
-// here we are undocking the ship
-bool undockShip(int dockIndex)
+void sendEndOfStep()
 {
-    if (!docks[dockIndex].occupied || docks[dockIndex].remainingCargo > 0)
+    MessageStruct nextMsg;
+    nextMsg.mtype = 5;
+    if (msgsnd(mainMsgQueueId, &nextMsg, sizeof(MessageStruct) - sizeof(long), 0) == -1)
     {
-        return false;
+        perror("msgsnd failed for end of timestep");
+        exit(EXIT_FAILURE);
     }
 
-    if (docks[dockIndex].lastCargoMovedTimestep == currentTimestep)
+    if (stepJournal != NULL)
     {
-        return false;
+        stepJournal->endOfStepSent = 1;
     }
+}
 
-    int stringLength = docks[dockIndex].lastCargoMovedTimestep - docks[dockIndex].dockingTimestep;
-    if (stringLength <= 0)
-        return false;
+// here we are telling the validator this timestep is done. the checkpoint is written and
+// the step marked complete first: once the validator has this message it may overwrite
+// the ship requests in shared memory, so from then on the step must never be replayed.
+// a failed checkpoint leaves the step incomplete, and a resume then refuses to continue
+// rather than replay a step the validator has already closed
+void finishStep()
+{
+    if (checkpointEnabled)
+    {
+        long long checkpointStart = statsClock();
+        if (writeCheckpoint())
+        {
+            stepJournal->stepComplete = 1;
+        }
+        recordPhase(PHASE_CHECKPOINT, &checkpointStart);
+    }
 
-    char correctAuthString[MAX_AUTH_STRING_LEN];
-    bool guessedCorrectly = false;
-    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
-    pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+    sendEndOfStep();
+}
 
-    pthread_t threads[numSolvers];
-    SolverThreadData threadData[numSolvers];
+// a solver thread of the crashed process may still have a guess in flight, and its
+// response must not be taken as the answer to one of our guesses
+void drainSolverQueues()
+{
+    struct timespec pause = {0, 50 * 1000 * 1000};
+    nanosleep(&pause, NULL);
 
     for (int i = 0; i < numSolvers; i++)
     {
-        threadData[i].dockIndex = dockIndex;
-        threadData[i].solverId = i;
-        threadData[i].guessedCorrectly = &guessedCorrectly;
-        threadData[i].correctAuthString = correctAuthString;
-        threadData[i].mutex = &mutex;
-        threadData[i].cond = &cond;
-
-        if (pthread_create(&threads[i], NULL, startSolverThread, &threadData[i]) != 0)
+        SolverResponse resp;
+        while (msgrcv(solverMsgQueueIds[i], &resp, sizeof(SolverResponse) - sizeof(long), 3, IPC_NOWAIT) != -1)
         {
-            perror("Failed to create thread");
-            return false;
         }
     }
+}
 
-    pthread_mutex_lock(&mutex);
-    if (!guessedCorrectly)
-    {
-        pthread_cond_wait(&cond, &mutex);
-    }
-    pthread_mutex_unlock(&mutex);
+// here we are restoring ships, docks and remaining cargo from the latest checkpoint.
+// docks must already be initialized from the input file so crane capacities are known
+void loadCheckpoint()
+{
+    long long start = monotonicNs();
 
-    for (int i = 0; i < numSolvers; i++)
+    FILE *file = fopen(checkpointPath, "rb");
+    if (file == NULL)
     {
-        pthread_join(threads[i], NULL);
+        perror("Failed to open checkpoint file");
+        exit(EXIT_FAILURE);
     }
 
-    pthread_mutex_destroy(&mutex);
-    pthread_cond_destroy(&cond);
+    fseek(file, 0, SEEK_END);
+    long fileSize = ftell(file);
+    fseek(file, 0, SEEK_SET);
 
-    if (!guessedCorrectly)
+    reserveCheckpointBuffer(fileSize);
+    if (fileSize < (long)sizeof(CheckpointHeader) || fread(checkpointBuffer, 1, fileSize, file) != (size_t)fileSize)
     {
-        return false;
+        fprintf(stderr, "Checkpoint file %s is truncated\n", checkpointPath);
+        exit(EXIT_FAILURE);
     }
+    fclose(file);
 
-    strcpy(shmPtr->authStrings[docks[dockIndex].id], correctAuthString);
+    char *in = checkpointBuffer;
+    char *end = checkpointBuffer + fileSize;
 
-    MessageStruct msg;
-    msg.mtype = 3;
-    msg.shipId = docks[dockIndex].shipId;
-    msg.direction = docks[dockIndex].direction;
-    msg.dockId = docks[dockIndex].id;
+    CheckpointHeader header;
+    memcpy(&header, in, sizeof(header));
+    in += sizeof(header);
 
-    if (msgsnd(mainMsgQueueId, &msg, sizeof(MessageStruct) - sizeof(long), 0) == -1)
+    if (header.magic != CHECKPOINT_MAGIC || header.version != CHECKPOINT_VERSION)
     {
-        perror("msgsnd failed for undocking");
+        fprintf(stderr, "Checkpoint file %s has an unknown format\n", checkpointPath);
+        exit(EXIT_FAILURE);
+    }
+    if (header.numDocks != numDocks || header.shipCount < 0)
+    {
+        fprintf(stderr, "Checkpoint file %s does not match this port configuration\n", checkpointPath);
         exit(EXIT_FAILURE);
     }
+    while (shipCapacity < header.shipCount)
+    {
+        growShips();
+    }
 
-    for (int i = 0; i < shipCount; i++)
+    for (int i = 0; i < numDocks; i++)
     {
-        if (ships[i].id == docks[dockIndex].shipId && ships[i].direction == docks[dockIndex].direction)
+        DockSnapshot snap;
+        if (in + sizeof(snap) > end)
+            goto truncated;
+        memcpy(&snap, in, sizeof(snap));
+        in += sizeof(snap);
+
+        if (snap.category != docks[i].category || snap.numCargo < 0 || snap.numCargo > MAX_CARGO_COUNT)
         {
-            ships[i].docked = false;
-            ships[i].serviced = true;
-            break;
+            fprintf(stderr, "Checkpoint file %s does not match dock %d\n", checkpointPath, i);
+            exit(EXIT_FAILURE);
+        }
+
+        docks[i].occupied = snap.occupied;
+        docks[i].shipId = snap.shipId;
+        docks[i].direction = snap.direction;
+        docks[i].dockingTimestep = snap.dockingTimestep;
+        docks[i].lastCargoMovedTimestep = snap.lastCargoMovedTimestep;
+        docks[i].remainingCargo = snap.remainingCargo;
+        docks[i].numCargo = snap.numCargo;
+
+        if (snap.occupied)
+        {
+            if (in + snap.numCargo * sizeof(int) > end)
+                goto truncated;
+
+            docks[i].remainingCargoWeights = reserveCargoBuffer(docks[i].remainingCargoWeights,
+                                                                &docks[i].cargoCapacity, snap.numCargo);
+            memcpy(docks[i].remainingCargoWeights, in, snap.numCargo * sizeof(int));
+            in += snap.numCargo * sizeof(int);
         }
+
+        updateFreeDock(i);
     }
 
-    docks[dockIndex].occupied = false;
-    free(docks[dockIndex].remainingCargoWeights);
-    docks[dockIndex].remainingCargoWeights = NULL;
+    shipCount = 0;
+    laneCount = 0;
+    laneMinCategory = INT_MAX;
+    for (int i = 0; i < header.shipCount; i++)
+    {
+        ShipSnapshot snap;
+        if (in + sizeof(snap) > end)
+            goto truncated;
+        memcpy(&snap, in, sizeof(snap));
+        in += sizeof(snap);
+
+        if (snap.numCargo < 0 || snap.numCargo > MAX_CARGO_COUNT || in + snap.numCargo * sizeof(int) > end)
+            goto truncated;
+
+        // waiting incoming emergencies go back on the lane, everyone else into ships
+        Ship *ship;
+        if (snap.direction == 1 && snap.emergency == 1 && !snap.docked && !snap.serviced)
+        {
+            ship = appendToEmergencyLane();
+            if (snap.category < laneMinCategory)
+                laneMinCategory = snap.category;
+            laneWakeup = true;
+        }
+        else
+        {
+            ship = &ships[shipCount++];
+        }
 
-    return true;
+        ship->id = snap.id;
+        ship->direction = snap.direction;
+        ship->category = snap.category;
+        ship->emergency = snap.emergency;
+        ship->waitingTime = snap.waitingTime;
+        ship->arrivalTimestep = snap.arrivalTimestep;
+        ship->numCargo = snap.numCargo;
+        ship->docked = snap.docked;
+        ship->dockId = snap.dockId;
+        ship->serviced = snap.serviced;
+        ship->remainingCargo = snap.remainingCargo;
+        ship->deadline = snap.deadline;
+        ship->cargoWeights = reserveCargoBuffer(ship->cargoWeights, &ship->cargoCapacity, snap.numCargo);
+        memcpy(ship->cargoWeights, in, snap.numCargo * sizeof(int));
+        in += snap.numCargo * sizeof(int);
+    }
+
+    currentTimestep = header.timestep;
+
+    fprintf(stderr, "Resumed from %s at timestep %d (%d ships, %d docks) in %.3f ms\n",
+            checkpointPath, currentTimestep, shipCount + laneCount, numDocks, (monotonicNs() - start) / 1e6);
+    return;
+
+truncated:
+    fprintf(stderr, "Checkpoint file %s is truncated\n", checkpointPath);
+    exit(EXIT_FAILURE);
 }
 
+#ifndef SCHEDULER_OFFLINE
 int main(int argc, char *argv[])
 {
-    if (argc != 2)
+    if (argc < 2)
     {
-        fprintf(stderr, "Usage: %s <testcase_number>\n", argv[0]);
+        fprintf(stderr, "Usage: %s <testcase_number> [--checkpoint] [--checkpoint-file <path>] [--resume] [--stats-key <key>] [--plan-horizon <timesteps>] [--solver-engine threaded|evloop] [--mem-budget <MB>] [--main-cpus <cpus>] [--solver-cpus <cpus>[:<cpus>...]] [--numa-local] [--realtime <priority>]\n", argv[0]);
         exit(EXIT_FAILURE);
     }
 
     int testCaseNum = atoi(argv[1]);
+    const char *mainCpuList = NULL;
+    const char *solverCpuList = NULL;
+    snprintf(checkpointPath, sizeof(checkpointPath), "testcase%d/scheduler.ckpt", testCaseNum);
+
+    for (int i = 2; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--checkpoint") == 0)
+        {
+            checkpointEnabled = true;
+        }
+        else if (strcmp(argv[i], "--checkpoint-file") == 0 && i + 1 < argc)
+        {
+            snprintf(checkpointPath, sizeof(checkpointPath), "%s", argv[++i]);
+        }
+        else if (strcmp(argv[i], "--solver-engine") == 0 && i + 1 < argc)
+        {
+            i++;
+            if (strcmp(argv[i], "evloop") == 0)
+                solverEngine = SOLVER_ENGINE_EVLOOP;
+            else if (strcmp(argv[i], "threaded") == 0)
+                solverEngine = SOLVER_ENGINE_THREADED;
+            else
+            {
+                fprintf(stderr, "Unknown solver engine: %s\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "--plan-horizon") == 0 && i + 1 < argc)
+        {
+            planHorizon = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--mem-budget") == 0 && i + 1 < argc)
+        {
+            memoryBudget = atoll(argv[++i]) * 1024 * 1024;
+            if (memoryBudget <= 0)
+            {
+                fprintf(stderr, "Memory budget must be at least 1 MB\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "--main-cpus") == 0 && i + 1 < argc)
+        {
+            mainCpuList = argv[++i];
+        }
+        else if (strcmp(argv[i], "--solver-cpus") == 0 && i + 1 < argc)
+        {
+            solverCpuList = argv[++i];
+        }
+        else if (strcmp(argv[i], "--numa-local") == 0)
+        {
+            numaLocalStacks = true;
+        }
+        else if (strcmp(argv[i], "--realtime") == 0 && i + 1 < argc)
+        {
+            realtimePriority = atoi(argv[++i]);
+            if (realtimePriority < sched_get_priority_min(SCHED_FIFO) || realtimePriority > sched_get_priority_max(SCHED_FIFO))
+            {
+                fprintf(stderr, "Realtime priority must be between %d and %d\n",
+                        sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO));
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "--stats-key") == 0 && i + 1 < argc)
+        {
+            statsKey = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--resume") == 0)
+        {
+            resumeFromCheckpoint = true;
+            checkpointEnabled = true;
+        }
+        else
+        {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
 
     char inputFilePath[100];
     sprintf(inputFilePath, "testcase%d/input.txt", testCaseNum);
@@ -758,7 +3038,18 @@ int main(int argc, char *argv[])
 
     fscanf(inputFile, "%d", &numSolvers);
 
-    int solverQueueKeys[MAX_SOLVERS];
+    if (numSolvers < 1)
+    {
+        fprintf(stderr, "Input has %d solvers, expected at least 1\n", numSolvers);
+        exit(EXIT_FAILURE);
+    }
+
+    int *solverQueueKeys = (int *)schedMalloc(MEM_SOLVER, numSolvers * sizeof(int));
+    if (solverQueueKeys == NULL)
+    {
+        perror("Failed to allocate memory for solver queue keys");
+        exit(EXIT_FAILURE);
+    }
     for (int i = 0; i < numSolvers; i++)
     {
         fscanf(inputFile, "%d", &solverQueueKeys[i]);
@@ -766,121 +3057,221 @@ int main(int argc, char *argv[])
 
     initializeDocks(inputFile);
     fclose(inputFile);
+    initializeFreeDocks();
+    configureThreadPlacement(mainCpuList, solverCpuList);
 
     SharedMemory(shmKey);
     MessageQueues(mainQueueKey, solverQueueKeys, numSolvers);
+    schedFree(MEM_SOLVER, solverQueueKeys);
+    if (statsKey != -1)
+    {
+        StatsSharedMemory(statsKey);
+    }
     initializeShips();
-    precomputeAuthStrings();
-    srand(time(NULL));
+    if (planHorizon > 0)
+    {
+        initializePlanner();
+    }
+    planAuthTables();
+    printMemoryReport("Memory at startup", false);
+    printAuthPlan();
+    printThreadPlacement();
+
+    pthread_t authWarmup;
+    bool replayPending = false;
+    bool finishStepAfterCheckpoint = false;
+    if (checkpointEnabled)
+    {
+        mapStepJournal();
+    }
 
-    bool finished = false;
-    while (!finished)
+    if (resumeFromCheckpoint)
     {
-        MessageStruct msg;
-        if (msgrcv(mainMsgQueueId, &msg, sizeof(MessageStruct) - sizeof(long), 1, 0) == -1)
+        loadCheckpoint();
+
+        // the journal tells us whether the crash happened between steps or in the middle of
+        // the step after the checkpoint; in the latter case the validator is still waiting on
+        // that step and its ship requests are still in shared memory, so we replay it
+        if (stepJournal->magic == CHECKPOINT_MAGIC && stepJournal->timestep == currentTimestep + 1 &&
+            (stepJournal->stepComplete || stepJournal->endOfStepSent))
         {
-            perror("msgrcv failed for new ship requests");
+            // the validator already has this step's end-of-step message but its checkpoint was
+            // never written, so the requests in shared memory may belong to the next step
+            fprintf(stderr, "Timestep %d was finished without a checkpoint, cannot replay it\n",
+                    stepJournal->timestep);
             exit(EXIT_FAILURE);
         }
-
-        currentTimestep = msg.timestep;
-        memset(craneUsedTimestep, 0, sizeof(craneUsedTimestep));
-
-        if (msg.isFinished)
+        else if (stepJournal->magic == CHECKPOINT_MAGIC && stepJournal->timestep == currentTimestep + 1)
         {
-            finished = true;
-            break;
+            replayPending = true;
+            replaySuppressCount = stepJournal->messagesSent;
+            replayUndockedDocks = stepJournal->undockedDocks;
+            drainSolverQueues();
+            fprintf(stderr, "Replaying timestep %d, skipping %d messages and %d undocks already sent\n",
+                    stepJournal->timestep, replaySuppressCount, __builtin_popcountll(replayUndockedDocks));
         }
-
-        int numNewRequests = msg.numShipRequests;
-        for (int i = 0; i < numNewRequests; i++)
+        else if (stepJournal->magic == CHECKPOINT_MAGIC && stepJournal->timestep != currentTimestep)
+        {
+            fprintf(stderr, "Step journal is at timestep %d but the checkpoint is at %d, cannot resume\n",
+                    stepJournal->timestep, currentTimestep);
+            exit(EXIT_FAILURE);
+        }
+        else if (stepJournal->magic == CHECKPOINT_MAGIC && !stepJournal->endOfStepSent)
         {
-            addShip(shmPtr->newShipRequests[i]);
+            // the step was checkpointed but the crash came before the validator was told it
+            // is done, so it is still waiting for exactly that message
+            fprintf(stderr, "Timestep %d was checkpointed, sending its end-of-step message\n",
+                    stepJournal->timestep);
+            finishStepAfterCheckpoint = true;
         }
 
-        bool emergencyHandled = processEmergencyShips();
-
-        if (numNewRequests > 0 || emergencyHandled)
+        // the warmup is background work, it gets neither the main thread's cpus nor its priority
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        if (mainPinned)
+            pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), &originalCpus);
+        if (realtimePriority > 0)
         {
-            qsort(ships, shipCount, sizeof(Ship), compareShipPriority);
+            struct sched_param param = {.sched_priority = 0};
+            pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+            pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
+            pthread_attr_setschedparam(&attr, &param);
         }
-
-        for (int i = 0; i < shipCount; i++)
+        int created = pthread_create(&authWarmup, &attr, authWarmupThread, NULL);
+        pthread_attr_destroy(&attr);
+        if (created != 0)
+        {
+            perror("Failed to create auth warmup thread");
+            exit(EXIT_FAILURE);
+        }
+    }
+    else
+    {
+        precomputeAuthStrings();
+        if (checkpointEnabled)
         {
-            if (!ships[i].docked && !ships[i].serviced)
+            beginStepJournal(0, 0);
+            if (!writeCheckpoint())
             {
-                if (ships[i].direction == 1 && ships[i].emergency == 0 &&
-                    currentTimestep > ships[i].deadline)
-                {
-                    continue;
-                }
-
-                int dockIndex = GetBestDock(i);
-                if (dockIndex != -1)
-                {
-                    dockShip(i, dockIndex);
-                }
+                fprintf(stderr, "Could not write the initial checkpoint to %s\n", checkpointPath);
+                exit(EXIT_FAILURE);
             }
+            stepJournal->stepComplete = 1;
+            stepJournal->endOfStepSent = 1;
         }
+    }
+    srand(time(NULL));
+
+    if (finishStepAfterCheckpoint)
+    {
+        sendEndOfStep();
+    }
 
-        for (int dockIndex = 0; dockIndex < numDocks; dockIndex++)
+    bool finished = false;
+    while (!finished)
+    {
+        MessageStruct msg;
+        if (replayPending)
+        {
+            msg.timestep = stepJournal->timestep;
+            msg.numShipRequests = stepJournal->numShipRequests;
+            msg.isFinished = 0;
+            replayPending = false;
+        }
+        else
         {
-            while (moveCargo(dockIndex))
+            if (msgrcv(mainMsgQueueId, &msg, sizeof(MessageStruct) - sizeof(long), 1, 0) == -1)
             {
-                // Keep moving cargo from this dock until no more can be moved
+                perror("msgrcv failed for new ship requests");
+                exit(EXIT_FAILURE);
             }
+            replaySuppressCount = 0;
+            replayUndockedDocks = 0;
         }
 
-        for (int dockIndex = 0; dockIndex < numDocks; dockIndex++)
-        {   
-            if(undockShip(dockIndex)==true)
-            {
-                continue;
-            }
-            else
-            {
-                continue;
-            }
+        beginStepJournal(msg.timestep, msg.numShipRequests);
+        currentTimestep = msg.timestep;
+
+        if (msg.isFinished)
+        {
+            finished = true;
+            break;
+        }
+
+        if (msg.numShipRequests < 0 || msg.numShipRequests > MAX_NEW_REQUESTS)
+        {
+            fprintf(stderr, "Timestep %d announces %d ship requests, shared memory holds %d\n",
+                    msg.timestep, msg.numShipRequests, MAX_NEW_REQUESTS);
+            exit(EXIT_FAILURE);
         }
 
-        MessageStruct nextMsg;
-        nextMsg.mtype = 5;
-        msgsnd(mainMsgQueueId, &nextMsg, sizeof(MessageStruct) - sizeof(long), 0);
+        processTimestep(msg.numShipRequests);
+        finishStep();
+        publishTimestepStats();
     }
 
-    for (int length = 1; length <= 10; length++)
+    if (resumeFromCheckpoint)
     {
-        for (int i = 0; i < authStringCounts[length]; i++)
-        {
-            free(precomputedStrings[length][i]);
-        }
-        free(precomputedStrings[length]);
+        pthread_join(authWarmup, NULL);
     }
-    free(precomputedStrings);
-    free(authStringCounts);
+
+    // the run completed, so there is nothing left to resume from
+    if (checkpointEnabled)
+    {
+        char journalPath[sizeof(checkpointPath) + 8];
+        snprintf(journalPath, sizeof(journalPath), "%s.journal", checkpointPath);
+        munmap(stepJournal, sizeof(StepJournal));
+        unlink(journalPath);
+        unlink(checkpointPath);
+    }
+
+    printSolverEngineReport();
+
+    if (checkpointsWritten > 0)
+    {
+        fprintf(stderr, "Checkpoints: %d written, %.1f us avg, %.1f us max per timestep\n",
+                checkpointsWritten, checkpointTotalNs / 1e3 / checkpointsWritten, checkpointMaxNs / 1e3);
+    }
+    printMemoryReport("Memory at exit", true);
+
+    schedFree(MEM_CHECKPOINT, checkpointBuffer);
+    releaseAuthStrings();
 
     for (int i = 0; i < numDocks; i++)
     {
-        free(docks[i].craneCapacities);
-        if (docks[i].remainingCargoWeights != NULL)
-        {
-            free(docks[i].remainingCargoWeights);
-        }
+        schedFree(MEM_DOCKS, docks[i].craneCapacities);
+        schedFree(MEM_DOCKS, docks[i].craneUsedEpoch);
+        schedFree(MEM_CARGO, docks[i].remainingCargoWeights);
+    }
+    schedFree(MEM_DOCKS, docks);
+    schedFree(MEM_DOCKS, dockRank);
+    schedFree(MEM_DOCKS, dockAtRank);
+    schedFree(MEM_DOCKS, categoryStartRank);
+    schedFree(MEM_DOCKS, freeDockBits);
+    schedFree(MEM_SOLVER, solverMsgQueueIds);
+    schedFree(MEM_SOLVER, solverCpuSets);
+    releaseSolverStacks();
+    schedFree(MEM_DOCKS, planAvailableAt);
+    schedFree(MEM_SHIPS, plannedDock);
+    schedFree(MEM_SHIPS, planCandidates);
+
+    for (int i = 0; i < shipCapacity; i++)
+    {
+        schedFree(MEM_CARGO, ships[i].cargoWeights);
     }
-    free(docks);
+    schedFree(MEM_SHIPS, ships);
 
-    for (int i = 0; i < shipCount; i++)
+    for (int i = 0; i < laneCapacity; i++)
     {
-        if (ships[i].cargoWeights != NULL)
-        {
-            free(ships[i].cargoWeights);
-        }
+        schedFree(MEM_CARGO, emergencyLane[i].cargoWeights);
     }
-    free(ships);
+    schedFree(MEM_SHIPS, emergencyLane);
 
     if (shmdt(shmPtr) == -1)
     {
         perror("shmdt failed");
     }
+    releaseStatsSharedMemory();
     return 0;
-}
\ No newline at end of file
+}
+#endif